@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "cheats.h"
+#include "memory.h"
+#include "mbc.h"
+
+static int hex_digits(const char *code, uint8_t *out, int max) {
+  int n = 0;
+  for (const char *c = code; *c; c++) {
+    if (*c == '-' || *c == ' ') continue;
+    if (!isxdigit((unsigned char)*c) || n == max) return -1;
+    out[n++] = (uint8_t)(isdigit((unsigned char)*c) ? *c - '0' : (tolower((unsigned char)*c) - 'a' + 10));
+  }
+  return n;
+}
+
+static int parse_gameshark(const uint8_t *d, Cheat_t *c) {
+  // TTVVLLHH: type, value, address low, address high
+  c->kind = CHEAT_GAMESHARK;
+  c->type = (uint8_t)(d[0] << 4 | d[1]);
+  c->value = (uint8_t)(d[2] << 4 | d[3]);
+  c->addy = (uint16_t)((d[6] << 12) | (d[7] << 8) | (d[4] << 4) | d[5]);
+  c->has_compare = false;
+  return (c->addy >= 0x8000) ? 0 : -1;
+}
+
+static int parse_gamegenie(const uint8_t *d, int n, Cheat_t *c) {
+  // ABC-DEF[-GHI]: AB value, FCDE address (F inverted), G.I compare
+  c->kind = CHEAT_GAMEGENIE;
+  c->type = 0;
+  c->value = (uint8_t)(d[0] << 4 | d[1]);
+  c->addy = (uint16_t)(((d[5] ^ 0xF) << 12) | (d[2] << 8) | (d[3] << 4) | d[4]);
+  c->has_compare = (n == 9);
+  if (c->has_compare) {
+    uint8_t cmp = (uint8_t)(d[6] << 4 | d[8]);
+    c->compare = (uint8_t)(((cmp >> 2) | (cmp << 6)) ^ 0xBA);
+  }
+  return (c->addy < 0x8000) ? 0 : -1;
+}
+
+static void cheat_patch_bank(Cartridge_t *cart, const Cheat_t *c, uint32_t bank, uint16_t off) {
+  uint8_t orig = cart->rom[bank * 0x4000u + off];
+  if (c->has_compare && orig != c->compare) return;
+  uint8_t *page = cart_rom_shadow(cart, (uint16_t)bank);
+  if (page) page[off] = c->value;
+}
+
+// Rebuilds every ROM shadow bank from the active Game Genie codes.
+static void cheat_patch_rom(Bus_t *bus) {
+  Cartridge_t *cart = bus->cartridge;
+  if (!cart) return;
+  cart_rom_unshadow(cart);
+  if (!bus->cheats) return;
+
+  for (int i = 0; i < bus->cheats->count; i++) {
+    const Cheat_t *c = &bus->cheats->codes[i];
+    if (c->kind != CHEAT_GAMEGENIE) continue;
+
+    uint16_t off = c->addy & 0x3FFF;
+    if (c->addy >= 0x4000) {
+      for (uint32_t bank = 1; bank < cart->rom_banks; bank++)
+        cheat_patch_bank(cart, c, bank, off);
+      continue;
+    }
+    // ROM0 is bank 0, except MBC1 mode 1 maps bank 0x20/0x40/0x60 there
+    int windows = (cart->type == MBC_1) ? 4 : 1;
+    for (int k = 0; k < windows; k++)
+      cheat_patch_bank(cart, c, ((uint32_t)k << 5) % cart->rom_banks, off);
+  }
+}
+
+int cheat_add(Bus_t *bus, const char *code) {
+  uint8_t d[9];
+  int n = hex_digits(code, d, 9);
+  Cheat_t c;
+  int err = -1;
+
+  if (n == 8) err = parse_gameshark(d, &c);
+  else if (n == 6 || n == 9) err = parse_gamegenie(d, n, &c);
+  if (err) {
+    fprintf(stderr, "[CHEAT] invalid code '%s'\n", code);
+    return -1;
+  }
+
+  if (!bus->cheats) {
+    bus->cheats = (Cheats_t*)calloc(1, sizeof(Cheats_t));
+    if (!bus->cheats) return -1;
+  }
+  if (bus->cheats->count == MAX_CHEATS) {
+    fprintf(stderr, "[CHEAT] too many codes\n");
+    return -1;
+  }
+  bus->cheats->codes[bus->cheats->count++] = c;
+
+  if (c.kind == CHEAT_GAMEGENIE) cheat_patch_rom(bus);
+  else bus->cheats->pokes++;
+  return 0;
+}
+
+void cheat_clear(Bus_t *bus) {
+  free(bus->cheats);
+  bus->cheats = NULL;
+  cheat_patch_rom(bus);
+}
+
+void cheat_apply_frame(Bus_t *bus) {
+  Cheats_t *cheats = bus->cheats;
+  if (!cheats || !cheats->pokes) return;
+
+  for (int i = 0; i < cheats->count; i++) {
+    const Cheat_t *c = &cheats->codes[i];
+    if (c->kind != CHEAT_GAMESHARK) continue;
+
+    if ((c->type & 0xF0) == 0x90 && c->addy >= 0xD000 && c->addy <= 0xDFFF) {
+      uint8_t bank = c->type & 0x07;
+      if (bank == 0) bank = 1;
+      uint16_t real_addr = 0x1000 + ((bank - 1) * 0x1000) + (c->addy - 0xD000);
+      bus->wram[real_addr] = c->value;
+      DIRTY_MARK(bus->dirty.wram, real_addr);
+    } else if ((c->type & 0xF0) == 0x80 && c->addy >= 0xA000 && c->addy <= 0xBFFF) {
+      Cartridge_t *cart = bus->cartridge;
+      size_t off = (size_t)(c->type & 0x0F) * 0x2000u + (c->addy - 0xA000);
+      if (cart && cart->ram && off < cart->ram_size) {
+        cart->ram[off] = c->value;
+        DIRTY_MARK(cart->ram_dirty, off);
+      }
+    } else {
+      write_byte_bus(bus, c->addy, c->value);
+    }
+  }
+}
@@ -0,0 +1,257 @@
+#include "compose.h"
+#include <stddef.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+// COMPOSE_NO_AVX2 lets tests/check_compose.c build the SSE2 and scalar paths
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(COMPOSE_NO_AVX2)
+#include <immintrin.h>
+#define COMPOSE_HAVE_AVX2 1
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+typedef void (*compose_fn)(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                           const uint32_t *colors, uint32_t *out);
+typedef void (*slots_fn)(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                         uint8_t *slots);
+
+typedef struct Compose_Kernel {
+  compose_fn argb;
+  slots_fn slots;
+} Compose_Kernel_t;
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+static inline void lookup(const uint8_t *slots, int n, const uint32_t *colors, uint32_t *out) {
+  for (int i = 0; i < n; i++) out[i] = 0xFF000000 | colors[slots[i]];
+}
+#endif
+
+/* ---------------- scalar ---------------- */
+
+#if !defined(__SSE2__) && !defined(__ARM_NEON)
+static inline uint8_t scalar_slot(const Ppu_Line_t *line, int x, uint8_t attr_mask, uint8_t bg_mask) {
+  uint8_t bg = line->bg_id[x];
+  uint8_t attr = line->bg_attr[x];
+  uint8_t obj = line->obj_id[x];
+  uint8_t obj_attr = line->obj_attr[x];
+
+  uint8_t slot = (uint8_t)(((attr & 7) << 2) | bg);
+  bool hide = (bg & bg_mask) && ((obj_attr | (attr & attr_mask)) & COMPOSE_OBJ_BEHIND);
+  if (obj && !hide)
+    slot = (uint8_t)(COMPOSE_OBJ_SLOT | ((obj_attr & 7) << 2) | obj);
+  return slot;
+}
+
+static void compose_scalar(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                           const uint32_t *colors, uint32_t *out) {
+  for (int x = 0; x < 160; x++)
+    out[x] = 0xFF000000 | colors[scalar_slot(line, x, attr_mask, bg_mask)];
+}
+
+static void slots_scalar(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                         uint8_t *slots) {
+  for (int x = 0; x < 160; x++)
+    slots[x] = scalar_slot(line, x, attr_mask, bg_mask);
+}
+#endif
+
+/* ---------------- SSE2 ---------------- */
+
+#if defined(__SSE2__)
+// Slot index for 16 pixels. Byte shifts are done as 16-bit shifts, which
+// is safe because every value is at most 7 before shifting.
+static inline __m128i sse2_slots16(const Ppu_Line_t *line, int x, __m128i attr_mask, __m128i bg_mask) {
+  const __m128i seven = _mm_set1_epi8(7);
+  const __m128i behind = _mm_set1_epi8((char)COMPOSE_OBJ_BEHIND);
+  const __m128i zero = _mm_setzero_si128();
+
+  __m128i bg = _mm_loadu_si128((const __m128i*)&line->bg_id[x]);
+  __m128i attr = _mm_loadu_si128((const __m128i*)&line->bg_attr[x]);
+  __m128i obj = _mm_loadu_si128((const __m128i*)&line->obj_id[x]);
+  __m128i obj_attr = _mm_loadu_si128((const __m128i*)&line->obj_attr[x]);
+
+  __m128i bg_slot = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(attr, seven), 2), bg);
+  __m128i obj_slot = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(obj_attr, seven), 2),
+                                  _mm_or_si128(obj, _mm_set1_epi8(COMPOSE_OBJ_SLOT)));
+
+  __m128i bg_clear = _mm_cmpeq_epi8(_mm_and_si128(bg, bg_mask), zero);
+  __m128i prio = _mm_or_si128(obj_attr, _mm_and_si128(attr, attr_mask));
+  __m128i behind_bg = _mm_cmpeq_epi8(_mm_and_si128(prio, behind), behind);
+  // BG wins where there is no sprite pixel or a priority flag covers it
+  __m128i use_bg = _mm_or_si128(_mm_cmpeq_epi8(obj, zero), _mm_andnot_si128(bg_clear, behind_bg));
+
+  return _mm_or_si128(_mm_and_si128(use_bg, bg_slot), _mm_andnot_si128(use_bg, obj_slot));
+}
+
+static void compose_sse2(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                         const uint32_t *colors, uint32_t *out) {
+  __m128i am = _mm_set1_epi8((char)attr_mask);
+  __m128i bm = _mm_set1_epi8((char)bg_mask);
+  uint8_t slots[16];
+
+  for (int x = 0; x < 160; x += 16) {
+    _mm_storeu_si128((__m128i*)slots, sse2_slots16(line, x, am, bm));
+    lookup(slots, 16, colors, out + x);
+  }
+}
+
+static void slots_sse2(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                       uint8_t *slots) {
+  __m128i am = _mm_set1_epi8((char)attr_mask);
+  __m128i bm = _mm_set1_epi8((char)bg_mask);
+
+  for (int x = 0; x < 160; x += 16)
+    _mm_storeu_si128((__m128i*)&slots[x], sse2_slots16(line, x, am, bm));
+}
+#endif
+
+/* ---------------- AVX2 ---------------- */
+
+#ifdef COMPOSE_HAVE_AVX2
+__attribute__((target("avx2")))
+static inline __m256i avx2_argb8(__m128i slots8, const uint32_t *colors) {
+  __m256i idx = _mm256_cvtepu8_epi32(slots8);
+  __m256i c = _mm256_i32gather_epi32((const int*)colors, idx, 4);
+  return _mm256_or_si256(c, _mm256_set1_epi32((int)0xFF000000));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_slots32(const Ppu_Line_t *line, int x, __m256i am, __m256i bm) {
+  const __m256i seven = _mm256_set1_epi8(7);
+  const __m256i behind = _mm256_set1_epi8((char)COMPOSE_OBJ_BEHIND);
+  const __m256i zero = _mm256_setzero_si256();
+
+  __m256i bg = _mm256_loadu_si256((const __m256i*)&line->bg_id[x]);
+  __m256i attr = _mm256_loadu_si256((const __m256i*)&line->bg_attr[x]);
+  __m256i obj = _mm256_loadu_si256((const __m256i*)&line->obj_id[x]);
+  __m256i obj_attr = _mm256_loadu_si256((const __m256i*)&line->obj_attr[x]);
+
+  __m256i bg_slot = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(attr, seven), 2), bg);
+  __m256i obj_slot = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(obj_attr, seven), 2),
+                                     _mm256_or_si256(obj, _mm256_set1_epi8(COMPOSE_OBJ_SLOT)));
+
+  __m256i bg_clear = _mm256_cmpeq_epi8(_mm256_and_si256(bg, bm), zero);
+  __m256i prio = _mm256_or_si256(obj_attr, _mm256_and_si256(attr, am));
+  __m256i behind_bg = _mm256_cmpeq_epi8(_mm256_and_si256(prio, behind), behind);
+  __m256i use_bg = _mm256_or_si256(_mm256_cmpeq_epi8(obj, zero),
+                                   _mm256_andnot_si256(bg_clear, behind_bg));
+  return _mm256_blendv_epi8(obj_slot, bg_slot, use_bg);
+}
+
+__attribute__((target("avx2")))
+static void compose_avx2(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                         const uint32_t *colors, uint32_t *out) {
+  const __m256i am = _mm256_set1_epi8((char)attr_mask);
+  const __m256i bm = _mm256_set1_epi8((char)bg_mask);
+
+  // 160 = 5 * 32, no tail
+  for (int x = 0; x < 160; x += 32) {
+    __m256i slot = avx2_slots32(line, x, am, bm);
+
+    __m128i lo = _mm256_castsi256_si128(slot);
+    __m128i hi = _mm256_extracti128_si256(slot, 1);
+    _mm256_storeu_si256((__m256i*)&out[x], avx2_argb8(lo, colors));
+    _mm256_storeu_si256((__m256i*)&out[x + 8], avx2_argb8(_mm_srli_si128(lo, 8), colors));
+    _mm256_storeu_si256((__m256i*)&out[x + 16], avx2_argb8(hi, colors));
+    _mm256_storeu_si256((__m256i*)&out[x + 24], avx2_argb8(_mm_srli_si128(hi, 8), colors));
+  }
+}
+
+__attribute__((target("avx2")))
+static void slots_avx2(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                       uint8_t *slots) {
+  const __m256i am = _mm256_set1_epi8((char)attr_mask);
+  const __m256i bm = _mm256_set1_epi8((char)bg_mask);
+
+  for (int x = 0; x < 160; x += 32)
+    _mm256_storeu_si256((__m256i*)&slots[x], avx2_slots32(line, x, am, bm));
+}
+#endif
+
+/* ---------------- NEON ---------------- */
+
+#if defined(__ARM_NEON)
+static inline uint8x16_t neon_slots16(const Ppu_Line_t *line, int x, uint8x16_t am, uint8x16_t bm) {
+  const uint8x16_t seven = vdupq_n_u8(7);
+  const uint8x16_t behind = vdupq_n_u8(COMPOSE_OBJ_BEHIND);
+
+  uint8x16_t bg = vld1q_u8(&line->bg_id[x]);
+  uint8x16_t attr = vld1q_u8(&line->bg_attr[x]);
+  uint8x16_t obj = vld1q_u8(&line->obj_id[x]);
+  uint8x16_t obj_attr = vld1q_u8(&line->obj_attr[x]);
+
+  uint8x16_t bg_slot = vorrq_u8(vshlq_n_u8(vandq_u8(attr, seven), 2), bg);
+  uint8x16_t obj_slot = vorrq_u8(vshlq_n_u8(vandq_u8(obj_attr, seven), 2),
+                                 vorrq_u8(obj, vdupq_n_u8(COMPOSE_OBJ_SLOT)));
+
+  uint8x16_t bg_opaque = vtstq_u8(bg, bm);
+  uint8x16_t behind_bg = vtstq_u8(vorrq_u8(obj_attr, vandq_u8(attr, am)), behind);
+  uint8x16_t use_obj = vbicq_u8(vtstq_u8(obj, obj), vandq_u8(bg_opaque, behind_bg));
+
+  return vbslq_u8(use_obj, obj_slot, bg_slot);
+}
+
+static void compose_neon(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                         const uint32_t *colors, uint32_t *out) {
+  const uint8x16_t am = vdupq_n_u8(attr_mask);
+  const uint8x16_t bm = vdupq_n_u8(bg_mask);
+  uint8_t slots[16];
+
+  for (int x = 0; x < 160; x += 16) {
+    vst1q_u8(slots, neon_slots16(line, x, am, bm));
+    lookup(slots, 16, colors, out + x);
+  }
+}
+
+static void slots_neon(const Ppu_Line_t *line, uint8_t attr_mask, uint8_t bg_mask,
+                       uint8_t *slots) {
+  const uint8x16_t am = vdupq_n_u8(attr_mask);
+  const uint8x16_t bm = vdupq_n_u8(bg_mask);
+
+  for (int x = 0; x < 160; x += 16)
+    vst1q_u8(&slots[x], neon_slots16(line, x, am, bm));
+}
+#endif
+
+static const Compose_Kernel_t *pick_kernel(void) {
+#ifdef COMPOSE_HAVE_AVX2
+  static const Compose_Kernel_t avx2 = { compose_avx2, slots_avx2 };
+  if (__builtin_cpu_supports("avx2")) return &avx2;
+#endif
+#if defined(__SSE2__)
+  static const Compose_Kernel_t sse2 = { compose_sse2, slots_sse2 };
+  return &sse2;
+#elif defined(__ARM_NEON)
+  static const Compose_Kernel_t neon = { compose_neon, slots_neon };
+  return &neon;
+#else
+  static const Compose_Kernel_t scalar = { compose_scalar, slots_scalar };
+  return &scalar;
+#endif
+}
+
+static const Compose_Kernel_t *kernel(void) {
+  static const Compose_Kernel_t *picked = NULL;
+  const Compose_Kernel_t *k = __atomic_load_n(&picked, __ATOMIC_RELAXED);
+  if (!k) {
+    k = pick_kernel();
+    __atomic_store_n(&picked, k, __ATOMIC_RELAXED);
+  }
+  return k;
+}
+
+void compose_line(const Ppu_Line_t *line, bool cgb, bool bg_master,
+                  const uint32_t *colors, uint32_t *out) {
+  uint8_t attr_mask = cgb ? COMPOSE_OBJ_BEHIND : 0;
+  uint8_t bg_mask = (!cgb || bg_master) ? 0x03 : 0;
+  kernel()->argb(line, attr_mask, bg_mask, colors, out);
+}
+
+void compose_line_slots(const Ppu_Line_t *line, bool cgb, bool bg_master, uint8_t *slots) {
+  uint8_t attr_mask = cgb ? COMPOSE_OBJ_BEHIND : 0;
+  uint8_t bg_mask = (!cgb || bg_master) ? 0x03 : 0;
+  kernel()->slots(line, attr_mask, bg_mask, slots);
+}
@@ -6,17 +6,20 @@
 #include "timers.h"
 #include "interrupts.h"
 #include "logging.h"
+#include "memprof.h"
 
 #define TRACE_LEN 4096
 
 #define TICK(cpu, n) do {                                                     \
     (cpu)->cycle += (n);                                                      \
+    uint32_t ppu_cycles = (n);                                                \
+    if ((cpu)->bus && (cpu)->bus->is_cgb && ((cpu)->bus->KEY1 & 0x80)) {      \
+        ppu_cycles >>= 1;                                                     \
+        if (ppu_cycles == 0) ppu_cycles = 1;                                  \
+    }                                                                         \
+    /* the RTC has its own crystal and keeps counting through STOP */         \
+    (cpu)->bus->cycles += ppu_cycles;                                         \
     if (!(cpu)->stopped) {                                                    \
-        uint32_t ppu_cycles = (n);                                            \
-        if ((cpu)->bus && (cpu)->bus->is_cgb && ((cpu)->bus->KEY1 & 0x80)) {  \
-            ppu_cycles >>= 1;                                                 \
-            if (ppu_cycles == 0) ppu_cycles = 1;                              \
-        }                                                                     \
         tick_timers(&(cpu)->bus->timers, ppu_cycles, &(cpu)->bus->IF);       \
         display_cycle((cpu)->ppu, (cpu)->bus, (int)ppu_cycles);              \
         bus_update_serial((cpu)->bus, (int)ppu_cycles);                      \
@@ -58,6 +61,7 @@ static inline u8 read8(registers_t *cpu, u16 addy) {
       }
     }
   }
+  MEMPROF_READ(cpu->bus, addy);
   return read_byte_bus(cpu->bus, addy);
 }
 
@@ -69,6 +73,7 @@ static inline void write8(registers_t *cpu, u16 addy, u8 val) {
       }
     }
   }
+  MEMPROF_WRITE(cpu->bus, addy);
   write_byte_bus(cpu->bus, addy, val);
 }
 
@@ -1334,6 +1339,16 @@ static inline bool irq_pending(registers_t* c) {
 }
 
 void helper(registers_t *cpu) {
+  // CPU is halted while CGB VRAM DMA runs: 32 dots per block, which is
+  // twice as many CPU cycles in double speed
+  if (cpu->ppu && cpu->ppu->hdma_stall) {
+    uint32_t stall = (uint32_t)cpu->ppu->hdma_stall;
+    cpu->ppu->hdma_stall = 0;
+    if (cpu->bus->is_cgb && (cpu->bus->KEY1 & 0x80)) stall <<= 1;
+    TICK(cpu, stall);
+    return;
+  }
+
   if (cpu->halt) {
     TICK(cpu, 4);
     if (irq_pending(cpu)) {
@@ -0,0 +1,20 @@
+#include <string.h>
+#include "dirty.h"
+#include "memory.h"
+#include "mbc.h"
+
+void bus_dirty_take(Bus_t *bus, Dirty_Set_t *out) {
+#ifdef DIRTY_PAGES
+  *out = bus->dirty;
+  memset(&bus->dirty, 0, sizeof(bus->dirty));
+
+  Cartridge_t *cart = bus->cartridge;
+  if (cart) {
+    memcpy(out->cart_ram, cart->ram_dirty, sizeof(out->cart_ram));
+    memset(cart->ram_dirty, 0, sizeof(cart->ram_dirty));
+  }
+#else
+  (void)bus;
+  memset(out, 0, sizeof(*out));
+#endif
+}
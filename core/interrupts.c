@@ -16,6 +16,7 @@ uint8_t read_byte_bus(Bus_t *bus, uint16_t addy);
 static inline void push_16(registers_t *cpu, u16 val) {
   cpu->SP--;
   cpu->cycle += 4;
+  cpu->bus->cycles += 4; // RTC time, runs through STOP
   if (!cpu->stopped) {
     tick_timers(&cpu->bus->timers, 4, &cpu->bus->IF);
     display_cycle(cpu->ppu, cpu->bus, 4);
@@ -23,6 +24,7 @@ static inline void push_16(registers_t *cpu, u16 val) {
   write_byte_bus(cpu->bus, cpu->SP, (u8)(val >> 8));
   cpu->SP--;
   cpu->cycle += 4;
+  cpu->bus->cycles += 4; // RTC time, runs through STOP
   if (!cpu->stopped) {
     tick_timers(&cpu->bus->timers, 4, &cpu->bus->IF);
     display_cycle(cpu->ppu, cpu->bus, 4);
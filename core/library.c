@@ -0,0 +1,388 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "library.h"
+#include "romcache.h"
+#include "unpack.h"
+
+#define INDEX_MAGIC "# romlib 1"
+
+typedef struct Scan_Job {
+  Rom_Entry_t entry;
+  bool ok;
+} Scan_Job_t;
+
+typedef struct Scan_Pool {
+  Scan_Job_t *jobs;
+  size_t count;
+  size_t next;
+} Scan_Pool_t;
+
+static int64_t file_mtime(const struct stat *st) {
+  return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+static int entry_cmp(const void *a, const void *b) {
+  return strcmp(((const Rom_Entry_t*)a)->path, ((const Rom_Entry_t*)b)->path);
+}
+
+static bool push_entry(Rom_Library_t *lib, const Rom_Entry_t *e) {
+  if (lib->count == lib->cap) {
+    size_t cap = lib->cap ? lib->cap * 2 : 256;
+    Rom_Entry_t *n = (Rom_Entry_t*)realloc(lib->entries, cap * sizeof(Rom_Entry_t));
+    if (!n) return false;
+    lib->entries = n;
+    lib->cap = cap;
+  }
+  lib->entries[lib->count++] = *e;
+  return true;
+}
+
+static bool is_rom_name(const char *name) {
+  const char *dot = strrchr(name, '.');
+  if (!dot) return false;
+  return strcasecmp(dot, ".gb") == 0 || strcasecmp(dot, ".gbc") == 0 ||
+         strcasecmp(dot, ".sgb") == 0 || strcasecmp(dot, ".gz") == 0 ||
+         strcasecmp(dot, ".zip") == 0;
+}
+
+/* ------------- header ------------- */
+
+static void parse_header(Rom_Entry_t *e, const uint8_t *rom) {
+  // CGB carts reuse the last title byte for the CGB flag
+  size_t len = (rom[0x143] & 0x80) ? 15 : 16;
+  size_t n = 0;
+  for (; n < len && rom[0x134 + n]; n++) {
+    uint8_t c = rom[0x134 + n];
+    e->title[n] = (c >= 0x20 && c < 0x7F && c != '\t') ? (char)c : '?';
+  }
+  while (n > 0 && e->title[n - 1] == ' ') n--;
+  e->title[n] = '\0';
+
+  e->is_cgb = (rom[0x143] == 0x80 || rom[0x143] == 0xC0);
+  e->is_sgb = (rom[0x146] == 0x03);
+  e->cart_type = rom[0x147];
+  e->mbc = get_cartridge_type(e->cart_type);
+  e->rom_size = get_cartridge_rom_size(rom[0x148]);
+  e->ram_size = get_cartridge_ram_size(rom[0x149]);
+
+  uint8_t x = 0;
+  for (uint16_t i = 0x134; i <= 0x14C; i++) x = (uint8_t)(x - rom[i] - 1);
+  e->header_checksum = rom[0x14D];
+  e->header_ok = (x == rom[0x14D]);
+  e->global_checksum = (uint16_t)((rom[0x14E] << 8) | rom[0x14F]);
+}
+
+static bool scan_file(Rom_Entry_t *e) {
+  int fd = open(e->path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 4) {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+
+  uint8_t *data = (uint8_t*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  bool mapped = (data != (uint8_t*)MAP_FAILED);
+  if (!mapped) {
+    data = (uint8_t*)malloc(size);
+    size_t got = 0;
+    while (data && got < size) {
+      ssize_t r = read(fd, data + got, size - got);
+      if (r <= 0) {
+        free(data);
+        data = NULL;
+      } else {
+        got += (size_t)r;
+      }
+    }
+  }
+  close(fd);
+  if (!data) return false;
+
+  // gzip/zip are indexed by their contents, hashed like the ROM cache does
+  const uint8_t *rom = data;
+  size_t rom_size = size;
+  uint8_t *unpacked = NULL;
+  if (unpack_is_compressed(data, size)) {
+    size_t padded;
+    unpacked = unpack_rom(data, size, &rom_size, &padded);
+    rom = unpacked;
+  }
+
+  bool ok = rom && rom_size >= 0x150;
+  if (ok) {
+    e->size = size;
+    e->mtime = file_mtime(&st);
+    parse_header(e, rom);
+    e->hash = rom_hash(rom, rom_size);
+  }
+
+  free(unpacked);
+  if (mapped) munmap(data, size);
+  else free(data);
+  return ok;
+}
+
+static void *scan_worker(void *arg) {
+  Scan_Pool_t *pool = (Scan_Pool_t*)arg;
+  for (;;) {
+    size_t i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    if (i >= pool->count) break;
+    pool->jobs[i].ok = scan_file(&pool->jobs[i].entry);
+  }
+  return NULL;
+}
+
+/* ------------- directory walk ------------- */
+
+// Appends every ROM under dir to found (path, size and mtime only)
+static int walk_dir(const char *dir, Rom_Library_t *found) {
+  DIR *d = opendir(dir);
+  if (!d) {
+    fprintf(stderr, "[LIB] cannot open %s\n", dir);
+    return -1;
+  }
+
+  struct dirent *de;
+  while ((de = readdir(d))) {
+    if (de->d_name[0] == '.') continue;
+
+    size_t n = strlen(dir) + strlen(de->d_name) + 2;
+    char *path = (char*)malloc(n);
+    if (!path) break;
+    snprintf(path, n, "%s/%s", dir, de->d_name);
+
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+      walk_dir(path, found);
+      free(path);
+      continue;
+    }
+    // symlinked files are fine, symlinked directories could loop
+    if (!is_rom_name(de->d_name) || stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+      free(path);
+      continue;
+    }
+
+    Rom_Entry_t e;
+    memset(&e, 0, sizeof(e));
+    e.path = path;
+    e.size = (uint64_t)st.st_size;
+    e.mtime = file_mtime(&st);
+    if (!push_entry(found, &e)) {
+      free(path);
+      break;
+    }
+  }
+  closedir(d);
+  return 0;
+}
+
+/* ------------- index file ------------- */
+
+static bool parse_line(char *line, Rom_Entry_t *e) {
+  char *field[13];
+  char *p = line;
+  for (int i = 0; i < 12; i++) {
+    field[i] = p;
+    p = strchr(p, '\t');
+    if (!p) return false;
+    *p++ = '\0';
+  }
+  field[12] = p; // path, may contain anything but a newline
+  p[strcspn(p, "\n")] = '\0';
+  if (!*p) return false;
+
+  memset(e, 0, sizeof(*e));
+  e->hash = strtoull(field[0], NULL, 16);
+  e->size = strtoull(field[1], NULL, 10);
+  e->mtime = strtoll(field[2], NULL, 10);
+  e->cart_type = (uint8_t)strtoul(field[3], NULL, 16);
+  e->mbc = (mbc_t)strtoul(field[4], NULL, 10);
+  e->is_cgb = field[5][0] == '1';
+  e->is_sgb = field[6][0] == '1';
+  e->rom_size = (size_t)strtoull(field[7], NULL, 10);
+  e->ram_size = (size_t)strtoull(field[8], NULL, 10);
+  e->header_checksum = (uint8_t)strtoul(field[9], NULL, 16);
+  e->header_ok = field[9][2] != '!'; // saved as XX! on mismatch
+  e->global_checksum = (uint16_t)strtoul(field[10], NULL, 16);
+  snprintf(e->title, sizeof(e->title), "%s", field[11]);
+  e->path = strdup(field[12]);
+  return e->path != NULL;
+}
+
+Rom_Library_t *library_open(const char *index_path) {
+  Rom_Library_t *lib = (Rom_Library_t*)calloc(1, sizeof(Rom_Library_t));
+  if (!lib) return NULL;
+  lib->index_path = strdup(index_path);
+  if (!lib->index_path) {
+    free(lib);
+    return NULL;
+  }
+
+  FILE *f = fopen(index_path, "r");
+  if (!f) return lib;
+
+  char *line = NULL;
+  size_t cap = 0;
+  if (getline(&line, &cap, f) > 0 && strncmp(line, INDEX_MAGIC, strlen(INDEX_MAGIC)) == 0) {
+    while (getline(&line, &cap, f) > 0) {
+      Rom_Entry_t e;
+      if (!parse_line(line, &e)) continue;
+      if (!push_entry(lib, &e)) {
+        free(e.path);
+        break;
+      }
+    }
+  } else {
+    fprintf(stderr, "[LIB] ignoring %s, unknown format\n", index_path);
+  }
+  free(line);
+  fclose(f);
+
+  qsort(lib->entries, lib->count, sizeof(Rom_Entry_t), entry_cmp);
+  return lib;
+}
+
+int library_save(const Rom_Library_t *lib) {
+  size_t n = strlen(lib->index_path) + 5;
+  char *tmp = (char*)malloc(n);
+  if (!tmp) return -1;
+  snprintf(tmp, n, "%s.tmp", lib->index_path);
+
+  FILE *f = fopen(tmp, "w");
+  if (!f) {
+    fprintf(stderr, "[LIB] cannot write %s\n", tmp);
+    free(tmp);
+    return -1;
+  }
+  fprintf(f, INDEX_MAGIC "\thash\tsize\tmtime\ttype\tmbc\tcgb\tsgb\trom\tram\thdr\tglobal\ttitle\tpath\n");
+  for (size_t i = 0; i < lib->count; i++) {
+    const Rom_Entry_t *e = &lib->entries[i];
+    fprintf(f, "%016llx\t%llu\t%lld\t%02X\t%d\t%d\t%d\t%zu\t%zu\t%02X%s\t%04X\t%s\t%s\n",
+            (unsigned long long)e->hash, (unsigned long long)e->size, (long long)e->mtime,
+            e->cart_type, (int)e->mbc, e->is_cgb, e->is_sgb, e->rom_size, e->ram_size,
+            e->header_checksum, e->header_ok ? "" : "!", e->global_checksum,
+            e->title, e->path);
+  }
+
+  // write-then-rename so a crash never leaves a truncated index
+  int rc = (fclose(f) == 0 && rename(tmp, lib->index_path) == 0) ? 0 : -1;
+  if (rc != 0) {
+    fprintf(stderr, "[LIB] failed to save %s\n", lib->index_path);
+    remove(tmp);
+  }
+  free(tmp);
+  return rc;
+}
+
+/* ------------- scan ------------- */
+
+int library_scan(Rom_Library_t *lib, const char *dir, int threads) {
+  Rom_Library_t found;
+  memset(&found, 0, sizeof(found));
+  if (walk_dir(dir, &found) != 0) return -1;
+
+  Scan_Pool_t pool;
+  memset(&pool, 0, sizeof(pool));
+  pool.jobs = (Scan_Job_t*)calloc(found.count ? found.count : 1, sizeof(Scan_Job_t));
+  if (!pool.jobs) {
+    for (size_t i = 0; i < found.count; i++) free(found.entries[i].path);
+    free(found.entries);
+    return -1;
+  }
+
+  // unchanged files keep their old entry, the rest go to the workers
+  Rom_Library_t next;
+  memset(&next, 0, sizeof(next));
+  size_t kept = 0;
+  for (size_t i = 0; i < found.count; i++) {
+    Rom_Entry_t *f = &found.entries[i];
+    Rom_Entry_t *old = (Rom_Entry_t*)bsearch(f, lib->entries, lib->count,
+                                             sizeof(Rom_Entry_t), entry_cmp);
+    if (old && old->size == f->size && old->mtime == f->mtime) {
+      Rom_Entry_t keep = *old;
+      keep.path = f->path;
+      if (push_entry(&next, &keep)) kept++;
+      else free(f->path);
+    } else {
+      pool.jobs[pool.count++].entry = *f;
+    }
+  }
+  free(found.entries);
+
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (cpus > 0) ? (int)cpus : 1;
+  }
+  if ((size_t)threads > pool.count) threads = (int)pool.count;
+
+  pthread_t *tids = (pthread_t*)calloc(threads ? threads : 1, sizeof(pthread_t));
+  int started = 0;
+  if (tids) {
+    for (; started < threads; started++) {
+      if (pthread_create(&tids[started], NULL, scan_worker, &pool) != 0) break;
+    }
+  }
+  // no threads at all still gets the work done on this one
+  if (started == 0) scan_worker(&pool);
+  for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+  free(tids);
+
+  int scanned = 0;
+  for (size_t i = 0; i < pool.count; i++) {
+    if (pool.jobs[i].ok && push_entry(&next, &pool.jobs[i].entry)) {
+      scanned++;
+    } else {
+      if (!pool.jobs[i].ok) fprintf(stderr, "[LIB] skipping %s\n", pool.jobs[i].entry.path);
+      free(pool.jobs[i].entry.path);
+    }
+  }
+  free(pool.jobs);
+
+  // anything not carried over unchanged means the index file is stale
+  lib->changed = scanned > 0 || kept != lib->count;
+  for (size_t i = 0; i < lib->count; i++) free(lib->entries[i].path);
+  free(lib->entries);
+  qsort(next.entries, next.count, sizeof(Rom_Entry_t), entry_cmp);
+  lib->entries = next.entries;
+  lib->count = next.count;
+  lib->cap = next.cap;
+  return scanned;
+}
+
+/* ------------- lookup ------------- */
+
+const Rom_Entry_t *library_find_path(const Rom_Library_t *lib, const char *path) {
+  Rom_Entry_t key;
+  memset(&key, 0, sizeof(key));
+  key.path = (char*)path;
+  return (const Rom_Entry_t*)bsearch(&key, lib->entries, lib->count,
+                                     sizeof(Rom_Entry_t), entry_cmp);
+}
+
+const Rom_Entry_t *library_find_hash(const Rom_Library_t *lib, uint64_t hash) {
+  for (size_t i = 0; i < lib->count; i++) {
+    if (lib->entries[i].hash == hash) return &lib->entries[i];
+  }
+  return NULL;
+}
+
+void library_free(Rom_Library_t *lib) {
+  if (!lib) return;
+  for (size_t i = 0; i < lib->count; i++) free(lib->entries[i].path);
+  free(lib->entries);
+  free(lib->index_path);
+  free(lib);
+}
@@ -3,10 +3,14 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <time.h>
+#include <pthread.h>
 #include "mbc.h"
+#include "romcache.h"
+#include "save.h"
 
 static const uint32_t MBC3_SECONDS_PER_DAY = 24u * 60u * 60u;
 static const uint16_t MBC3_DAY_MAX = 512u;
+static const uint64_t MBC3_RTC_HZ = 4194304u;
 
 static void mbc3_rtc_update_regs(Cartridge_t *cart);
 static void mbc3_rtc_tick(Cartridge_t *cart);
@@ -51,6 +55,17 @@ mbc_t get_cartridge_type(uint8_t type) {
   }
 }
 
+static bool cartridge_has_battery(uint8_t type) {
+  switch (type) {
+    case 0x03: case 0x06: case 0x09: case 0x0D:
+    case 0x0F: case 0x10: case 0x13:
+    case 0x1B: case 0x1E: case 0x22:
+      return true;
+    default:
+      return false;
+  }
+}
+
 size_t get_cartridge_rom_size(uint8_t val) {
   if (val <= 8)
     return (size_t)0x8000u << val; 
@@ -84,36 +99,30 @@ size_t get_cartridge_ram_size(uint8_t val) {
   }
 }
 
+static const Mapper_t *mapper_for(mbc_t type);
+
+// Reads of ROM banks past the end of the image. Filled once: carts
+// already loaded on other threads read it through their bank pointers.
+static uint8_t unmapped_rom[0x4000];
+static pthread_once_t unmapped_rom_once = PTHREAD_ONCE_INIT;
+
+static void fill_unmapped_rom(void) {
+  memset(unmapped_rom, 0xFF, sizeof(unmapped_rom));
+}
+
 Cartridge_t *load_cart(const char *path) {
+  Rom_Image_t *img = rom_cache_acquire(path);
+  if (!img) return NULL;
 
-  FILE *f = fopen(path, "rb");
-  if (!f) { perror("Open ROM"); return NULL; }
-  fseek(f, 0, SEEK_END);
-  long len = ftell(f);
-  fseek(f, 0, SEEK_SET);
-  if (len <= 0) {
-    fclose(f);
-    return NULL;
-  }
-  
-  uint8_t *buf = (uint8_t*)malloc((size_t)len);
-  if (!buf) {
-    fprintf(stderr, "Failed to allocate buffer for cartridge\n");
-    fclose(f);
-    return NULL;
-  }
-  if (fread(buf, 1, (size_t)len, f) != (size_t)len) {
-    fclose(f);
-    free(buf);
-    return NULL;
-  }
-  fclose(f);
+  uint8_t *buf = img->data;
+  size_t len = img->size;
+  size_t padded = img->padded;
 
   Cartridge_t *cart = (Cartridge_t*)calloc(1, sizeof(Cartridge_t));
 
   if (!cart) {
     fprintf(stderr, "failed to allocate cart\n");
-    free(buf);
+    rom_cache_release(img);
     return NULL;
   }
 
@@ -133,17 +142,27 @@ Cartridge_t *load_cart(const char *path) {
   uint8_t rom_size_code = buf[0x148];
   uint8_t ram_size_code = buf[0x149];
 
-  size_t file_size = (size_t)len;
+  size_t file_size = len;
   size_t header_size = get_cartridge_rom_size(rom_size_code);
 
+  cart->rom_image = img;
   cart->rom = buf;
   cart->rom_size = file_size;
 
   cart->type = get_cartridge_type(cart_type);
+  cart->mapper = mapper_for(cart->type);
+  pthread_once(&unmapped_rom_once, fill_unmapped_rom);
   
-  cart->rom_banks = (uint16_t)(cart->rom_size / 0x4000);
-  if (cart->rom_banks == 0) {
-    cart->rom_banks = 1;
+  cart->rom_banks = (uint16_t)(padded / 0x4000);
+  cart->rom_map = (uint8_t**)malloc(cart->rom_banks * sizeof(uint8_t*));
+  if (!cart->rom_map) {
+    fprintf(stderr, "failed to allocate rom bank map\n");
+    rom_cache_release(img);
+    free(cart);
+    return NULL;
+  }
+  for (uint16_t i = 0; i < cart->rom_banks; i++) {
+    cart->rom_map[i] = cart->rom + (size_t)i * 0x4000u;
   }
 
   if (header_size && header_size != file_size) {
@@ -170,48 +189,64 @@ Cartridge_t *load_cart(const char *path) {
   cart->rtc_day_carry = false;
   cart->rtc_total_seconds = 0;
   cart->rtc_latch_prev = 0;
-  cart->rtc_last_update = time(NULL);
+  cart->rtc_clock = NULL;
+  cart->rtc_last_cycles = 0;
+  cart->rtc_saved_stamp = 0;
+
+  if (cartridge_has_battery(cart_type)) {
+    save_open(cart, path);
+  }
+  cart_map_banks(cart);
   return cart;
 }
 
 void free_cart(Cartridge_t *cart) {
   if (!cart) return;
-  free(cart->ram);
-  free(cart->rom);
+  cart_rom_unshadow(cart);
+  free(cart->rom_map);
+  if (cart->save) save_close(cart);
+  else free(cart->ram);
+  rom_cache_release(cart->rom_image);
   free(cart);
 }
 
-static inline uint8_t read_mbc0(Cartridge_t *cart, uint16_t addy) {
-  if (addy < 0x8000) {
-    return (addy < cart->rom_size) ? cart->rom[addy] : 0xFF;
-  }
+uint8_t *cart_rom_shadow(Cartridge_t *cart, uint16_t bank) {
+  if (bank >= cart->rom_banks) return NULL;
 
-  if (addy >= 0xA000 && addy <= 0xBFFF) {
-    if (!cart->ram || cart->ram_size == 0) return 0xFF;
-    size_t offset = (size_t)(addy - 0xA000);
-    return (offset < cart->ram_size) ? cart->ram[offset] : 0xFF;
+  uint8_t *orig = cart->rom + (size_t)bank * 0x4000u;
+  if (cart->rom_map[bank] != orig) return cart->rom_map[bank];
+
+  uint8_t *page = (uint8_t*)malloc(0x4000);
+  if (!page) {
+    fprintf(stderr, "[MBC] failed to allocate shadow bank %u\n", bank);
+    return NULL;
   }
-  return 0xFF;
+  memcpy(page, orig, 0x4000);
+  cart->rom_map[bank] = page;
+  cart_map_banks(cart);
+  return page;
 }
 
-static inline void write_mbc0(Cartridge_t *cart, uint16_t addy, uint8_t val) {
-  if (addy >= 0xA000 && addy <= 0xBFFF && cart->ram && cart->ram_size) {
-    size_t offset = (size_t)(addy - 0xA000);
-    cart->ram[offset] = val;
+void cart_rom_unshadow(Cartridge_t *cart) {
+  for (uint16_t i = 0; i < cart->rom_banks; i++) {
+    uint8_t *orig = cart->rom + (size_t)i * 0x4000u;
+    if (cart->rom_map[i] != orig) {
+      free(cart->rom_map[i]);
+      cart->rom_map[i] = orig;
+    }
   }
+  cart_map_banks(cart);
 }
 
-static inline uint8_t read_mbc_bytes(Cartridge_t *cart, uint32_t bank_num, uint16_t addy) {
-  // skip legacy
-  //bank_num %= cart->rom_banks;
-  uint32_t base = bank_num * 0x4000u;
-  uint32_t offset = base + (addy & 0x3FFF);
-
-  if (offset < cart->rom_size) {
-    return cart->rom[offset];
-  }
+static inline void cart_ram_written(Cartridge_t *cart, size_t off) {
+  DIRTY_MARK(cart->ram_dirty, off);
+  if (cart->save) save_mark(cart->save, off);
+}
 
-  return 0xFF;
+static inline void cart_set_ram_enable(Cartridge_t *cart, bool enable) {
+  bool was_enabled = cart->ram_enable;
+  cart->ram_enable = enable;
+  if (was_enabled && !enable && cart->save) save_request_flush(cart);
 }
 
 static void mbc3_rtc_get_components(const Cartridge_t *cart,
@@ -269,175 +304,235 @@ static void mbc3_rtc_set_components(Cartridge_t *cart,
   mbc3_rtc_update_regs(cart);
 }
 
+static void mbc3_rtc_advance(Cartridge_t *cart, uint64_t seconds) {
+  uint64_t total = (uint64_t)cart->rtc_total_seconds + seconds;
+  uint64_t limit = (uint64_t)MBC3_DAY_MAX * (uint64_t)MBC3_SECONDS_PER_DAY;
+  if (total >= limit) {
+    cart->rtc_day_carry = true;
+    total %= limit;
+  }
+  cart->rtc_total_seconds = (uint32_t)total;
+}
+
+// Catches the clock up with emulated time. Sub-second cycles carry over
+// to the next tick.
 static void mbc3_rtc_tick(Cartridge_t *cart) {
+  uint64_t now = cart->rtc_clock ? *cart->rtc_clock : cart->rtc_last_cycles;
+
+  if (cart->rtc_halt) {
+    cart->rtc_last_cycles = now;
+  } else if (now > cart->rtc_last_cycles) {
+    uint64_t seconds = (now - cart->rtc_last_cycles) / MBC3_RTC_HZ;
+    cart->rtc_last_cycles += seconds * MBC3_RTC_HZ;
+    if (seconds) mbc3_rtc_advance(cart, seconds);
+  }
+
+  mbc3_rtc_update_regs(cart);
+}
+
+void cart_rtc_sync_wallclock(Cartridge_t *cart) {
+  if (cart->type != MBC_3 || !cart->rtc_saved_stamp) return;
+
   time_t now = time(NULL);
-  if (now == (time_t)-1) {
-    now = cart->rtc_last_update;
+  if (now != (time_t)-1 && !cart->rtc_halt && (int64_t)now > cart->rtc_saved_stamp) {
+    mbc3_rtc_advance(cart, (uint64_t)((int64_t)now - cart->rtc_saved_stamp));
+    mbc3_rtc_update_regs(cart);
   }
+  cart->rtc_saved_stamp = 0;
+}
+
+static void put32(uint8_t *out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out[i] = (uint8_t)(v >> (i * 8));
+}
 
-  if (cart->rtc_last_update == 0) {
-    cart->rtc_last_update = now;
+static uint32_t get32(const uint8_t *in) {
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// 48-byte save footer: regs, latched regs, unix time of the snapshot
+void cart_rtc_store(Cartridge_t *cart, uint8_t *out) {
+  mbc3_rtc_tick(cart);
+  for (int i = 0; i < 5; i++) {
+    put32(out + i * 4, cart->rtc_regs[i]);
+    put32(out + 20 + i * 4, cart->rtc_latched_regs[i]);
   }
+  time_t now = time(NULL);
+  uint64_t stamp = (now == (time_t)-1) ? 0 : (uint64_t)now;
+  put32(out + 40, (uint32_t)stamp);
+  put32(out + 44, (uint32_t)(stamp >> 32));
+}
 
-  if (!cart->rtc_halt && now > cart->rtc_last_update) {
-    time_t delta = now - cart->rtc_last_update;
-    if (delta > 0) {
-      uint64_t total = (uint64_t)cart->rtc_total_seconds + (uint64_t)delta;
-      uint64_t limit = (uint64_t)MBC3_DAY_MAX * (uint64_t)MBC3_SECONDS_PER_DAY;
-      if (total >= limit) {
-        cart->rtc_day_carry = true;
-        total %= limit;
-      }
-      cart->rtc_total_seconds = (uint32_t)total;
-    }
+void cart_rtc_load(Cartridge_t *cart, const uint8_t *in) {
+  uint8_t regs[5];
+  for (int i = 0; i < 5; i++) {
+    regs[i] = (uint8_t)get32(in + i * 4);
+    cart->rtc_latched_regs[i] = (uint8_t)get32(in + 20 + i * 4);
   }
+  cart->rtc_halt = (regs[4] & 0x40u) != 0;
+  cart->rtc_day_carry = (regs[4] & 0x80u) != 0;
+  mbc3_rtc_set_components(cart, (uint16_t)(regs[3] | ((regs[4] & 0x01u) << 8)),
+                          regs[2], regs[1], regs[0]);
 
-  cart->rtc_last_update = now;
-  mbc3_rtc_update_regs(cart);
+  // only cart_rtc_sync_wallclock() looks at when the save was written
+  cart->rtc_saved_stamp = (int64_t)((uint64_t)get32(in + 40) | ((uint64_t)get32(in + 44) << 32));
 }
 
-/* --------------- MBC1 --------------- */
+/* -------------- banking -------------- */
 
-uint8_t read_mbc1(Cartridge_t *cart, uint16_t addy) {
+static inline uint8_t *rom_bank_ptr(const Cartridge_t *cart, uint32_t bank) {
+  return (bank < cart->rom_banks) ? cart->rom_map[bank] : unmapped_rom;
+}
 
-  if (addy < 0x4000) {
-    if (cart->mode == 1) {
-      uint32_t bank = ((uint32_t)(cart->ram_bank & 0x03)) << 5;
-      if (bank >= cart->rom_banks) bank %= cart->rom_banks;
-      return read_mbc_bytes(cart, bank, addy);
-    }
-    return read_mbc_bytes(cart, 0, addy);
+// Turns the bank numbers picked by the mapper into the base pointers
+// cart_read uses. sram is only set when a whole 8KB window of plain RAM
+// is mapped; everything else goes through the mapper's read_ram.
+void cart_map_banks(Cartridge_t *cart) {
+  cart->mapper->map_banks(cart);
+
+  cart->rom0 = rom_bank_ptr(cart, cart->rom0_bank);
+  cart->romx = rom_bank_ptr(cart, cart->romx_bank);
+  cart->sram = NULL;
+  if (cart->ram && cart->sram_off >= 0 && (size_t)cart->sram_off + 0x2000u <= cart->ram_size)
+    cart->sram = cart->ram + cart->sram_off;
 }
 
+static inline long ram_bank_off(const Cartridge_t *cart, uint32_t bank) {
+  if (!cart->ram || cart->ram_size == 0) return -1;
+  return (long)((bank % (cart->ram_banks ? cart->ram_banks : 1)) * 0x2000u);
+}
 
-  if (addy >= 0x4000 && addy <= 0x7FFF) {  
-    uint32_t low5 = (uint32_t)(cart->rom_bank & 0x1F);
-    uint32_t hi2  = (cart->mode == 0)
-                      ? (uint32_t)(cart->ram_bank & 0x03)
-                      : 0;
-    uint32_t bank = (hi2 << 5) | low5;
+static uint8_t read_ram_plain(Cartridge_t *cart, uint16_t addy) {
+  if (cart->sram_off < 0) return 0xFF;
+  size_t off = (size_t)cart->sram_off + (addy - 0xA000);
+  return (off < cart->ram_size) ? cart->ram[off] : 0xFF;
+}
 
-    if (bank >= cart->rom_banks) bank %= cart->rom_banks;
-    if ((bank & 0x1F) == 0) bank |= 1;          
+static void write_ram_plain(Cartridge_t *cart, uint16_t addy, uint8_t val) {
+  if (cart->sram_off < 0) return;
+  size_t off = (size_t)cart->sram_off + (addy - 0xA000);
+  if (off < cart->ram_size) {
+    cart->ram[off] = val;
+    cart_ram_written(cart, off);
+  }
+}
 
-    static int log_cnt = 0;
-    if (log_cnt < 32) {
-      fprintf(stderr, "[MBC1] ROM read bank=%u pc_bank=%u hi=%u mode=%u\n",
-              bank, cart->rom_bank & 0x1F, hi2, cart->mode);
-      log_cnt++;
-    }
-    return read_mbc_bytes(cart, bank, addy);
+/* --------------- MBC0 --------------- */
+
+static void map_mbc0(Cartridge_t *cart) {
+  cart->rom0_bank = 0;
+  cart->romx_bank = 1;
+  cart->sram_off = ram_bank_off(cart, 0);
 }
 
-  if (addy >= 0xA000 && addy <= 0xBFFF) {
-    if (!cart->ram || !cart->ram_enable) return 0xFF;
-    uint32_t bank = (cart->mode == 1) ? (uint32_t)(cart->ram_bank & 0x03) : 0;
-    bank %= (cart->ram_banks ? cart->ram_banks : 1);
-    size_t off = bank * 0x2000u + (addy - 0xA000);
-    return (off < cart->ram_size) ? cart->ram[off] : 0xFF;
-  }
+static void write_mbc0(Cartridge_t *cart, uint16_t addy, uint8_t val) {
+  if (addy >= 0xA000 && addy <= 0xBFFF) write_ram_plain(cart, addy, val);
+}
 
-  return 0xFF;
+/* --------------- MBC1 --------------- */
+
+static void map_mbc1(Cartridge_t *cart) {
+  uint32_t banks = cart->rom_banks;
+
+  uint32_t bank = (cart->mode == 1) ? ((uint32_t)(cart->ram_bank & 0x03)) << 5 : 0;
+  cart->rom0_bank = (bank >= banks) ? bank % banks : bank;
+
+  uint32_t hi2 = (cart->mode == 0) ? (uint32_t)(cart->ram_bank & 0x03) : 0;
+  bank = (hi2 << 5) | (uint32_t)(cart->rom_bank & 0x1F);
+  if (bank >= banks) bank %= banks;
+  if ((bank & 0x1F) == 0) bank |= 1;
+  cart->romx_bank = bank;
+
+  cart->sram_off = cart->ram_enable
+    ? ram_bank_off(cart, (cart->mode == 1) ? (uint32_t)(cart->ram_bank & 0x03) : 0)
+    : -1;
 }
 
-void write_mbc1(Cartridge_t *cart, uint16_t addy, uint8_t val) {
+static void write_mbc1(Cartridge_t *cart, uint16_t addy, uint8_t val) {
   if (addy < 0x2000) {
-    cart->ram_enable = ((val & 0x0F) == 0xA);
-    static int log_cnt = 0;
-    if (log_cnt < 16) {
-      fprintf(stderr, "[MBC1] RAM enable <= %d (val=%02X)\n", cart->ram_enable, val);
-      log_cnt++;
-    }
-    return; 
-  }
-
-  if (addy >= 0x2000 && addy <= 0x3FFF) {
+    cart_set_ram_enable(cart, (val & 0x0F) == 0xA);
+  } else if (addy <= 0x3FFF) {
     uint8_t low5 = val & 0x1F;
-    if (low5 == 0) low5 = 1;                  
+    if (low5 == 0) low5 = 1;
     cart->rom_bank = (cart->rom_bank & ~0x1F) | low5;
-    static int log_cnt = 0;
-    if (log_cnt < 32) {
-      fprintf(stderr, "[MBC1] ROM bank low set -> %u (val=%02X)\n",
-              cart->rom_bank & 0x1F, val);
-      log_cnt++;
-    }
-    return;
-    }
-  
-  if (addy >= 0x4000 && addy <= 0x5FFF) {
+  } else if (addy <= 0x5FFF) {
     cart->ram_bank = (val & 0x03);
-    static int log_cnt = 0;
-    if (log_cnt < 32) {
-      fprintf(stderr, "[MBC1] RAM/ROM high bits set -> %u (val=%02X)\n",
-              cart->ram_bank & 0x03, val);
-      log_cnt++;
-    }
-    return;
-  }
-
-  if (addy >= 0x6000 && addy <= 0x7FFF) {
+  } else if (addy <= 0x7FFF) {
     cart->mode = (val & 0x01);
-    static int log_cnt = 0;
-    if (log_cnt < 16) {
-      fprintf(stderr, "[MBC1] MODE set -> %u (val=%02X)\n", cart->mode, val);
-      log_cnt++;
-    }
+  } else {
+    if (addy >= 0xA000 && addy <= 0xBFFF) write_ram_plain(cart, addy, val);
     return;
   }
+  cart_map_banks(cart);
+}
 
-  if (addy >= 0xA000 && addy <= 0xBFFF) {
-    if (!cart->ram || !cart->ram_enable) 
-      return;
+/* -------------- MBC3 ------------------- */
 
-    uint32_t bank = (cart->mode == 1) ? (uint32_t)(cart->ram_bank & 0x03) : 0;
-    bank %= (cart->ram_banks ? cart->ram_banks : 1);
+static void map_mbc3(Cartridge_t *cart) {
+  uint32_t bank = cart->rom_bank & 0x7F;
+  bank %= cart->rom_banks;
+  if (bank == 0 && cart->rom_banks > 1) bank = 1;
+  cart->rom0_bank = 0;
+  cart->romx_bank = bank;
+  cart->sram_off = (cart->ram_enable && cart->ram_bank <= 3) ? ram_bank_off(cart, cart->ram_bank) : -1;
+}
 
-    size_t off = bank * 0x2000u + (addy - 0xA000);
-    if (off < cart->ram_size) cart->ram[off] = val;
+static uint8_t read_ram_mbc3(Cartridge_t *cart, uint16_t addy) {
+  if (!cart->ram_enable)
+    return 0xFF;
+
+  if (cart->ram_bank >= 0x08 && cart->ram_bank <= 0x0C) {
+    uint8_t index = (uint8_t)(cart->ram_bank - 0x08);
+    if (!cart->rtc_latched) {
+      mbc3_rtc_tick(cart);
+      return cart->rtc_regs[index];
+    }
+    return cart->rtc_latched_regs[index];
   }
+  return read_ram_plain(cart, addy);
 }
 
-/* -------------- MBC3 ------------------- */
-uint8_t read_mbc3(Cartridge_t* cart, uint16_t addy) {
-  if (addy < 0x4000) {
-    return read_mbc_bytes(cart, 0, addy);
-  } else if (addy >= 0x4000 && addy <= 0x7FFF) {
-    uint32_t bank = cart->rom_bank & 0x7F;
-    if (cart->rom_banks) {
-      bank %= cart->rom_banks;
-      if (bank == 0 && cart->rom_banks > 1) bank = 1;
-    }
-    return read_mbc_bytes(cart, bank, addy);
-  } else if (addy >= 0xA000 && addy <= 0xBFFF) {
-    if (!cart->ram_enable)
-      return 0xFF;
-
-    if (cart->ram_bank <= 3 && cart->ram) {
-      uint8_t bank = cart->ram_bank;
-      uint16_t effective = cart->ram_banks ? cart->ram_banks : 1;
-      bank %= effective;
-      size_t off = ((size_t)bank * 0x2000u) + (addy - 0xA000);
-      if (off < cart->ram_size)
-	return cart->ram[off];
-      return 0xFF;
-    } else if (cart->ram_bank >= 0x08 && cart->ram_bank <= 0x0C) {
-      uint8_t index = (uint8_t)(cart->ram_bank - 0x08);
-      if (!cart->rtc_latched) {
-	mbc3_rtc_tick(cart);
-	return cart->rtc_regs[index];
-      }
-      return cart->rtc_latched_regs[index];
+static void write_rtc_mbc3(Cartridge_t *cart, uint8_t val) {
+  mbc3_rtc_tick(cart);
+
+  uint16_t days;
+  uint8_t hours, minutes, seconds;
+  mbc3_rtc_get_components(cart, &days, &hours, &minutes, &seconds);
+
+  switch (cart->ram_bank) {
+    case 0x08:
+      seconds = (uint8_t)(val % 60u);
+      if (cart->rtc_clock) cart->rtc_last_cycles = *cart->rtc_clock; // resets the sub-second divider
+      break;
+    case 0x09:
+      minutes = (uint8_t)(val % 60u);
+      break;
+    case 0x0A:
+      hours = (uint8_t)(val % 24u);
+      break;
+    case 0x0B:
+      days = (uint16_t)((days & 0x100u) | val);
+      days %= MBC3_DAY_MAX;
+      break;
+    case 0x0C: {
+      uint16_t new_days = (uint16_t)(((uint16_t)(val & 0x01u) << 8) | (days & 0xFFu));
+      days = new_days % MBC3_DAY_MAX;
+
+      // already ticked above, so toggling halt starts from the current cycle
+      cart->rtc_halt = (val & 0x40u) != 0;
+      cart->rtc_day_carry = (val & 0x80u) != 0;
+      break;
     }
+    default:
+      break;
   }
-  return 0xFF;
-} 
 
-void write_mbc3(Cartridge_t *cart, uint16_t addy, uint8_t val) {
+  mbc3_rtc_set_components(cart, days, hours, minutes, seconds);
+}
+
+static void write_mbc3(Cartridge_t *cart, uint16_t addy, uint8_t val) {
   if (addy < 0x2000) {
-    cart->ram_enable = ((val & 0x0F) == 0x0A);
-    return;
-  }
-  if (addy >= 0x2000 && addy < 0x3FFF) {
+    cart_set_ram_enable(cart, (val & 0x0F) == 0x0A);
+  } else if (addy < 0x3FFF) {
     uint16_t bank = (uint16_t)(val & 0x7F);
     if (bank == 0) bank = 1;
     if (cart->rom_banks) {
@@ -446,14 +541,9 @@ void write_mbc3(Cartridge_t *cart, uint16_t addy, uint8_t val) {
       if (cart->rom_banks == 1) bank = 0;
     }
     cart->rom_bank = (uint8_t)bank;
-    return;
-  }
-
-  if (addy >= 0x4000 && addy <= 0x5FFF) {
+  } else if (addy >= 0x4000 && addy <= 0x5FFF) {
     cart->ram_bank = val;
-    return;
-  }
-  if (addy >= 0x6000 && addy <= 0x7FFF) {
+  } else if (addy >= 0x6000 && addy <= 0x7FFF) {
     uint8_t latch_val = val & 0x01u;
     if (cart->rtc_latch_prev == 0 && latch_val == 1) {
       mbc3_rtc_tick(cart);
@@ -465,148 +555,92 @@ void write_mbc3(Cartridge_t *cart, uint16_t addy, uint8_t val) {
     }
     cart->rtc_latch_prev = latch_val;
     return;
-  }
-
-  if (addy >= 0xA000 && addy <= 0xBFFF && cart->ram_enable) {
-    if (cart->ram_bank <= 3 && cart->ram) {
-      uint8_t bank = cart->ram_bank;
-      uint16_t effective = cart->ram_banks ? cart->ram_banks : 1;
-      bank %= effective;
-      size_t off = ((size_t)bank * 0x2000u) + (addy - 0xA000);
-      if (off < cart->ram_size)
-	cart->ram[off] = val;
-    } else if (cart->ram_bank >= 0x08 && cart->ram_bank <= 0x0C) {
-      mbc3_rtc_tick(cart);
-
-      uint16_t days;
-      uint8_t hours, minutes, seconds;
-      mbc3_rtc_get_components(cart, &days, &hours, &minutes, &seconds);
-
-      switch (cart->ram_bank) {
-	case 0x08:
-	  seconds = (uint8_t)(val % 60u);
-	  break;
-	case 0x09:
-	  minutes = (uint8_t)(val % 60u);
-	  break;
-	case 0x0A:
-	  hours = (uint8_t)(val % 24u);
-	  break;
-	case 0x0B:
-	  days = (uint16_t)((days & 0x100u) | val);
-	  days %= MBC3_DAY_MAX;
-	  break;
-	case 0x0C: {
-	  uint16_t new_days = (uint16_t)(((uint16_t)(val & 0x01u) << 8) | (days & 0xFFu));
-	  days = new_days % MBC3_DAY_MAX;
-
-	  bool halt = (val & 0x40u) != 0;
-	  if (cart->rtc_halt != halt) {
-	    cart->rtc_last_update = time(NULL);
-	    if (cart->rtc_last_update == (time_t)-1) cart->rtc_last_update = 0;
-	  }
-	  cart->rtc_halt = halt;
-	  cart->rtc_day_carry = (val & 0x80u) != 0;
-	  break;
-	}
-	default:
-	  break;
-      }
-
-      mbc3_rtc_set_components(cart, days, hours, minutes, seconds);
+  } else {
+    if (addy >= 0xA000 && addy <= 0xBFFF && cart->ram_enable) {
+      if (cart->ram_bank >= 0x08 && cart->ram_bank <= 0x0C) write_rtc_mbc3(cart, val);
+      else write_ram_plain(cart, addy, val);
     }
+    return;
   }
+  cart_map_banks(cart);
 }
 
-uint8_t read_mbc5(Cartridge_t *cart, uint16_t addy) {
-  if (addy < 0x4000) {
-    return read_mbc_bytes(cart, 0, addy);
-  }
-
-  if (addy >= 0x4000 && addy <= 0x7FFF) {
-    uint16_t bank = (uint16_t)cart->rom_bank | ((uint16_t)(cart->mode & 0x01) << 8);
-
-    if (bank >= cart->rom_banks) 
-      bank %= cart->rom_banks;
-
-    return read_mbc_bytes(cart, bank, addy);
-  }
+/* -------------- MBC5 ------------------- */
 
-  if (addy >= 0xA000 && addy <= 0xBFFF) {
-    if (!cart->ram || !cart->ram_enable) 
-      return 0xFF;
-
-    uint32_t bank = (uint32_t)(cart->ram_bank & 0x0F);
-    
-    bank %= (cart->ram_banks ? cart->ram_banks : 1);
-    
-    size_t off = bank * 0x2000u + (addy - 0xA000);
-    return (off < cart->ram_size) ? cart->ram[off] : 0xFF;
-  }
-
-  return 0xFF;
+static void map_mbc5(Cartridge_t *cart) {
+  uint32_t bank = (uint32_t)cart->rom_bank | ((uint32_t)(cart->mode & 0x01) << 8);
+  cart->rom0_bank = 0;
+  cart->romx_bank = (bank >= cart->rom_banks) ? bank % cart->rom_banks : bank;
+  cart->sram_off = cart->ram_enable ? ram_bank_off(cart, (uint32_t)(cart->ram_bank & 0x0F)) : -1;
 }
 
-void write_mbc5(Cartridge_t *cart, uint16_t addy, uint8_t val) {
+static void write_mbc5(Cartridge_t *cart, uint16_t addy, uint8_t val) {
   if (addy < 0x2000) {
-    cart->ram_enable = ((val & 0x0F) == 0x0A);
-    return;
-  }
-
-  if (addy >= 0x2000 && addy <= 0x2FFF) {
+    cart_set_ram_enable(cart, (val & 0x0F) == 0x0A);
+  } else if (addy <= 0x2FFF) {
     cart->rom_bank = val;
-    return;
-  }
-
-  if (addy >= 0x3000 && addy <= 0x3FFF) {
+  } else if (addy <= 0x3FFF) {
     cart->mode = val & 0x01;
-    return;
-  }
-
-  if (addy >= 0x4000 && addy <= 0x5FFF) {
+  } else if (addy <= 0x5FFF) {
     cart->ram_bank = val & 0x0F;
+  } else {
+    if (addy >= 0xA000 && addy <= 0xBFFF) write_ram_plain(cart, addy, val);
     return;
   }
+  cart_map_banks(cart);
+}
 
-  if (addy >= 0xA000 && addy <= 0xBFFF) {
-    if (!cart->ram || !cart->ram_enable) return;
+static const Mapper_t mappers[] = {
+  [MBC_0] = { "MBC0", map_mbc0, read_ram_plain, write_mbc0 },
+  [MBC_1] = { "MBC1", map_mbc1, read_ram_plain, write_mbc1 },
+  [MBC_3] = { "MBC3", map_mbc3, read_ram_mbc3, write_mbc3 },
+  [MBC_5] = { "MBC5", map_mbc5, read_ram_plain, write_mbc5 },
+};
 
-    uint32_t bank = (uint32_t)(cart->ram_bank & 0x0F);
-    bank %= (cart->ram_banks ? cart->ram_banks : 1);
+static const Mapper_t *mapper_for(mbc_t type) {
+  if ((size_t)type >= sizeof(mappers) / sizeof(mappers[0])) return &mappers[MBC_0];
+  return &mappers[type];
+}
 
-    size_t off = bank * 0x2000u + (addy - 0xA000);
-    if (off < cart->ram_size) cart->ram[off] = val;
-  }
+/* ------------ host pointers ------------ */
+
+uint32_t cart_rom_bank(const Cartridge_t *cart, uint16_t addy) {
+  return (addy < 0x4000) ? cart->rom0_bank : cart->romx_bank;
 }
 
-uint8_t cart_read(Cartridge_t *cart, uint16_t addy) {
-  switch (cart->type) {
-    case MBC_0:
-      return read_mbc0(cart, addy);
-    case MBC_1:
-      return read_mbc1(cart, addy);
-    case MBC_3:
-      return read_mbc3(cart, addy);
-    case MBC_5:
-      return read_mbc5(cart, addy);
-    default:
-      return read_mbc0(cart, addy);
+uint8_t *cart_host_ptr(Cartridge_t *cart, uint16_t addy, uint16_t *span) {
+  if (!cart) return NULL;
+
+  if (addy < 0x8000) {
+    if (cart_rom_bank(cart, addy) >= cart->rom_banks) return NULL;
+    if (span) *span = (uint16_t)(0x4000 - (addy & 0x3FFF));
+    return ((addy < 0x4000) ? cart->rom0 : cart->romx) + (addy & 0x3FFF);
   }
+
+  if (addy >= 0xA000 && addy <= 0xBFFF) {
+    if (cart->sram_off < 0) return NULL;
+    size_t off = (size_t)cart->sram_off + (addy - 0xA000);
+    if (off >= cart->ram_size) return NULL;
+    size_t n = 0x2000u - (addy - 0xA000);
+    if (n > cart->ram_size - off) n = cart->ram_size - off;
+    if (span) *span = (uint16_t)n;
+    return cart->ram + off;
+  }
+  return NULL;
+}
+
+uint8_t cart_read_slow(Cartridge_t *cart, uint16_t addy) {
+  if (addy >= 0xA000 && addy <= 0xBFFF)
+    return cart->mapper->read_ram(cart, addy);
+  return 0xFF;
 }
 
 void cart_write(Cartridge_t *cart, uint16_t addy, uint8_t val) {
-  switch (cart->type) {
-    case MBC_0:
-      return write_mbc0(cart, addy, val);
-    case MBC_1:
-      return write_mbc1(cart, addy, val);
-    case MBC_3:
-      return write_mbc3(cart, addy, val);
-    case MBC_5:
-      return write_mbc5(cart, addy, val);
-    default:
-      return write_mbc0(cart, addy, val);
+  if (cart->sram && addy >= 0xA000 && addy <= 0xBFFF) {
+    size_t off = (size_t)cart->sram_off + (addy - 0xA000);
+    cart->ram[off] = val;
+    cart_ram_written(cart, off);
+    return;
   }
+  cart->mapper->write(cart, addy, val);
 }
-
-
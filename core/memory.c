@@ -25,6 +25,7 @@ void init_bus(Bus_t* b) {
 int bus_load_rom(Bus_t *bus, const char *path) {
   bus->cartridge = load_cart(path);
   if (bus->cartridge) {
+    bus->cartridge->rtc_clock = &bus->cycles;
     bus->is_cgb = bus->cartridge->is_cgb;
     fprintf(stderr, "[BUS] CGB mode: %s\n", bus->is_cgb ? "ENABLED" : "disabled");
     if (bus->cartridge->is_sgb && !bus->is_cgb) {
@@ -188,6 +189,7 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
   if (bus->ppu && bus->ppu->dma_active) {
     if (addy >= 0xFF80 && addy <= 0xFFFE) {
       bus->hram[addy - 0xFF80] = val;
+      DIRTY_MARK(bus->dirty.hram, 0);
     }
     return;
   }
@@ -205,6 +207,7 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
       return;
     }
     bus->vram[real_addy] = val;
+    DIRTY_MARK(bus->dirty.vram, real_addy);
     return;
   }
 
@@ -214,6 +217,7 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
   }
   if (addy >= 0xC000 && addy <= 0xCFFF) {
     bus->wram[addy - 0xC000] = val;
+    DIRTY_MARK(bus->dirty.wram, addy - 0xC000);
     return;
   }
 
@@ -224,10 +228,12 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
     uint16_t offset = addy - 0xD000;
     uint16_t real_addr = 0x1000 + ((bank - 1) * 0x1000) + offset;
     bus->wram[real_addr] = val;
+    DIRTY_MARK(bus->dirty.wram, real_addr);
     return;
   }
   if (addy >= 0xE000 && addy <= 0xEFFF) {
     bus->wram[addy - 0xE000] = val;  // Mirrors 0xC000-0xCFFF
+    DIRTY_MARK(bus->dirty.wram, addy - 0xE000);
     return;
   }
   if (addy >= 0xF000 && addy <= 0xFDFF) {
@@ -237,10 +243,13 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
     uint16_t offset = addy - 0xF000;
     uint16_t real_addr = 0x1000 + ((bank - 1) * 0x1000) + offset;
     bus->wram[real_addr] = val;  // Mirrors 0xD000-0xDFFF
+    DIRTY_MARK(bus->dirty.wram, real_addr);
     return;
   }
   if (addy >= 0xFE00 && addy <= 0xFE9F) {
     bus->oam[addy - 0xFE00] = val;
+    DIRTY_MARK(bus->dirty.oam, 0);
+    if (bus->ppu) bus->ppu->oam_version++;
     return;
   }
   if (addy >= 0xFEA0 && addy <= 0xFEFF) return;
@@ -276,36 +285,19 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
     case 0xFF3A: case 0xFF3B: case 0xFF3C: case 0xFF3D: case 0xFF3E: case 0xFF3F:
       bus->audio_regs[addy - 0xFF10] = val;
       return;
-    case 0xFF40: {
-      uint8_t old_lcdc = bus->ppu->LCDC;
-      bus->ppu->LCDC = val;
-      
-      bool was_enabled = (old_lcdc & 0x80) != 0;
-      bool is_enabled = (val & 0x80) != 0;
-      
-      if (!was_enabled && is_enabled) {
-        bus->ppu->LY = 0;
-        bus->ppu->cycles_in_line = 0;
-        bus->ppu->STAT = (bus->ppu->STAT & ~0x03) | 2; // Start in mode 2 (OAM scan)
-      } else if (was_enabled && !is_enabled) {
-        bus->ppu->LY = 0;
-        bus->ppu->cycles_in_line = 0;
-        bus->ppu->STAT = (bus->ppu->STAT & ~0x03) | 0; 
-      }
-      return;
-    }
-    case 0xFF41: bus->ppu->STAT = (val & 0x78) | (bus->ppu->STAT & 0x07); return;
+    case 0xFF40: ppu_write_lcdc(bus->ppu, val); return;
+    case 0xFF41: ppu_write_stat(bus->ppu, val); return;
     case 0xFF42: bus->ppu->SCY = val; return;
     case 0xFF43: bus->ppu->SCX = val; return;
     case 0xFF44: return; // LY is read only
-    case 0xFF45: bus->ppu->LYC = val; return;
+    case 0xFF45: ppu_write_lyc(bus->ppu, val); return;
     case 0xFF46:
       bus->ppu->DMA = val;
       bus->ppu->dma_pending = true;
       return;
-    case 0xFF47: bus->ppu->BGP = val; return;
-    case 0xFF48: bus->ppu->OBP0 = val; return;
-    case 0xFF49: bus->ppu->OBP1 = val; return;
+    case 0xFF47: bus->ppu->BGP = val; ppu_update_dmg_colors(bus->ppu); return;
+    case 0xFF48: bus->ppu->OBP0 = val; ppu_update_dmg_colors(bus->ppu); return;
+    case 0xFF49: bus->ppu->OBP1 = val; ppu_update_dmg_colors(bus->ppu); return;
     case 0xFF50:
       return;
     case 0xFF4A: bus->ppu->WY = val; return;
@@ -339,17 +331,13 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
 
       uint16_t length = (uint16_t)(((val & 0x7F) + 1) * 0x10);
 
-      // General-purpose DMA (bit7 == 0): transfer all at once
+      // General-purpose DMA (bit7 == 0): transfer all at once, CPU is
+      // halted for 32 dots per 16-byte block
       if (!(val & 0x80)) {
         bus->ppu->hdma_active = false;
         bus->ppu->HDMA5 = 0xFF;
-        for (uint16_t i = 0; i < length; i++) {
-          uint8_t data = read_byte_bus(bus, src + i);
-          uint16_t dst_addr = dst + i;
-          if (dst_addr >= 0x8000 && dst_addr < 0xA000) {
-            write_byte_bus(bus, dst_addr, data);
-          }
-        }
+        bus_vram_dma(bus, src, dst, length);
+        bus->ppu->hdma_stall += (length / 0x10) * 32;
       } else {
         // HBlank HDMA (bit7 == 1): set up state, transfer 16 bytes at each HBlank
         bus->ppu->hdma_active = true;
@@ -369,6 +357,7 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
     case 0xFF69: {
       uint8_t byte = bus->ppu->BCPS & 0x3F;
       bus->ppu->bg_pallete[byte] = val;
+      ppu_update_cgb_color(bus->ppu, false, byte);
       if (bus->ppu->BCPS & 0x80) {
 	bus->ppu->BCPS = 0x80 | ((byte + 1) & 0x3F);
       }
@@ -378,6 +367,7 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
     case 0xFF6B: {
       uint8_t byte = bus->ppu->OCPS & 0x3F;
       bus->ppu->obj_pallete[byte] = val;
+      ppu_update_cgb_color(bus->ppu, true, byte);
       if (bus->ppu->OCPS & 0x80) {
 	bus->ppu->OCPS = 0x80 | ((byte + 1) & 0x3F);
       }
@@ -388,6 +378,7 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
 
   if (addy >= 0xFF80 && addy <= 0xFFFE) {
     bus->hram[addy - 0xFF80] = val; 
+    DIRTY_MARK(bus->dirty.hram, 0);
     return;
   }
   if (addy == 0xFFFF) {
@@ -396,6 +387,64 @@ void write_byte_bus(Bus_t *bus, uint16_t addy, uint8_t val) {
   }
 }
 
+uint8_t *bus_host_ptr(Bus_t *bus, uint16_t addy, uint16_t *span) {
+  if (bus->ppu && bus->ppu->dma_active) return NULL;
+  if (bus->bootrom_enabled && bus->bootrom && addy < 0x0900) return NULL;
+
+  if (addy < 0x8000 || (addy >= 0xA000 && addy <= 0xBFFF))
+    return cart_host_ptr(bus->cartridge, addy, span);
+
+  if (addy <= 0x9FFF) {
+    if (span) *span = (uint16_t)(0xA000 - addy);
+    return &bus->vram[(addy - 0x8000) + ((bus->VBK & 0x01) * 0x2000)];
+  }
+
+  if (addy >= 0xFE00) return NULL;
+  uint16_t end = 0xE000;
+  if (addy >= 0xE000) {
+    addy -= 0x2000; // echo of 0xC000-0xDDFF
+    end = 0xDE00;
+  }
+
+  if (addy <= 0xCFFF) {
+    if (span) *span = (uint16_t)(0xD000 - addy);
+    return &bus->wram[addy - 0xC000];
+  }
+  uint8_t bank = bus->SVBK & 0x07;
+  if (bank == 0) bank = 1;
+  if (span) *span = (uint16_t)(end - addy);
+  return &bus->wram[0x1000 + ((bank - 1) * 0x1000) + (addy - 0xD000)];
+}
+
+void bus_vram_dma(Bus_t *bus, uint16_t src, uint16_t dst, uint16_t len) {
+  uint16_t i = 0;
+  while (i < len) {
+    uint16_t s_addr = (uint16_t)(src + i);
+    uint16_t d_addr = (uint16_t)(dst + i);
+    // Destination is always in VRAM region 0x8000-0x9FF0
+    if (d_addr < 0x8000 || d_addr >= 0xA000) {
+      i++;
+      continue;
+    }
+
+    uint16_t n = len - i;
+    if (n > 0xA000 - d_addr) n = (uint16_t)(0xA000 - d_addr);
+
+    uint16_t span = 0;
+    uint8_t *from = bus_host_ptr(bus, s_addr, &span);
+    if (!from || !bus->ppu) {
+      write_byte_bus(bus, d_addr, read_byte_bus(bus, s_addr));
+      i++;
+      continue;
+    }
+    if (n > span) n = span;
+
+    uint16_t vram_addr = (uint16_t)((d_addr - 0x8000) + ((bus->VBK & 0x01) * 0x2000));
+    ppu_vram_write_block(bus->ppu, vram_addr, from, n);
+    i += n;
+  }
+}
+
 void bus_update_serial(Bus_t *bus, int cycles) {
   if (bus->serial_cycles > 0) {
     bus->serial_cycles -= cycles;
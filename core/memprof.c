@@ -0,0 +1,248 @@
+#include <stdlib.h>
+#include <string.h>
+#include "memprof.h"
+#include "memory.h"
+#include "mbc.h"
+
+#ifdef PROFILE_MEM
+
+typedef struct {
+  uint32_t reads;
+  uint32_t writes;
+} Mem_Count_t;
+
+typedef struct Mem_Prof {
+  Mem_Count_t *rom;     // by ROM offset, so split by bank
+  size_t rom_lines;
+  Mem_Count_t *cart_ram;
+  size_t cart_ram_lines;
+  Mem_Count_t mbc[0x8000 >> MEMPROF_LINE_SHIFT]; // writes to ROM area
+  Mem_Count_t vram[0x4000 >> MEMPROF_LINE_SHIFT];
+  Mem_Count_t wram[0x8000 >> MEMPROF_LINE_SHIFT];
+  Mem_Count_t oam[0xA0 >> MEMPROF_LINE_SHIFT];
+  Mem_Count_t io[0x100]; // FF00-FFFF per address
+  Mem_Count_t other[0x10000 >> MEMPROF_LINE_SHIFT]; // no backing memory
+} Mem_Prof_t;
+
+typedef enum {
+  PROF_ROM = 0,
+  PROF_MBC,
+  PROF_VRAM,
+  PROF_CART_RAM,
+  PROF_WRAM,
+  PROF_OAM,
+  PROF_IO,
+  PROF_OTHER,
+} prof_region_t;
+
+static const char *region_names[] = {
+  "rom", "mbc", "vram", "cart_ram", "wram", "oam", "io", "other"
+};
+
+typedef struct {
+  prof_region_t region;
+  uint16_t bank;
+  uint16_t addy;
+  Mem_Count_t count;
+} Mem_Hot_t;
+
+static Mem_Prof_t *memprof_get(Bus_t *bus) {
+  if (bus->prof) return bus->prof;
+
+  Mem_Prof_t *p = (Mem_Prof_t*)calloc(1, sizeof(Mem_Prof_t));
+  if (!p) {
+    fprintf(stderr, "[PROF] failed to allocate profiler\n");
+    return NULL;
+  }
+  Cartridge_t *cart = bus->cartridge;
+  if (cart) {
+    p->rom_lines = cart->rom_size >> MEMPROF_LINE_SHIFT;
+    p->rom = (Mem_Count_t*)calloc(p->rom_lines, sizeof(Mem_Count_t));
+    p->cart_ram_lines = cart->ram_size >> MEMPROF_LINE_SHIFT;
+    if (p->cart_ram_lines)
+      p->cart_ram = (Mem_Count_t*)calloc(p->cart_ram_lines, sizeof(Mem_Count_t));
+  }
+  bus->prof = p;
+  return p;
+}
+
+static inline void bump(Mem_Count_t *c, bool write) {
+  if (write) c->writes++;
+  else c->reads++;
+}
+
+void memprof_access(Bus_t *bus, uint16_t addy, bool write) {
+  Mem_Prof_t *p = memprof_get(bus);
+  if (!p) return;
+
+  if (addy >= 0xFF00) {
+    bump(&p->io[addy - 0xFF00], write);
+    return;
+  }
+  if (addy >= 0xFE00 && addy <= 0xFE9F) {
+    bump(&p->oam[(addy - 0xFE00) >> MEMPROF_LINE_SHIFT], write);
+    return;
+  }
+  if (addy < 0x8000 && write) {
+    bump(&p->mbc[addy >> MEMPROF_LINE_SHIFT], write);
+    return;
+  }
+
+  Cartridge_t *cart = bus->cartridge;
+  uint16_t span;
+  uint8_t *ptr = bus_host_ptr(bus, addy, &span);
+  if (ptr && addy < 0x8000 && p->rom) {
+    size_t line = ((size_t)cart_rom_bank(cart, addy) * 0x4000u + (addy & 0x3FFF)) >> MEMPROF_LINE_SHIFT;
+    if (line < p->rom_lines) {
+      bump(&p->rom[line], write);
+      return;
+    }
+  } else if (ptr && addy >= 0xA000 && addy <= 0xBFFF && p->cart_ram) {
+    size_t line = (size_t)(ptr - cart->ram) >> MEMPROF_LINE_SHIFT;
+    if (line < p->cart_ram_lines) {
+      bump(&p->cart_ram[line], write);
+      return;
+    }
+  } else if (ptr && addy >= 0x8000 && addy <= 0x9FFF) {
+    bump(&p->vram[(ptr - bus->vram) >> MEMPROF_LINE_SHIFT], write);
+    return;
+  } else if (ptr && addy >= 0xC000) {
+    bump(&p->wram[(ptr - bus->wram) >> MEMPROF_LINE_SHIFT], write);
+    return;
+  }
+  bump(&p->other[addy >> MEMPROF_LINE_SHIFT], write);
+}
+
+// Guest address and bank of a line index within one region.
+static void line_location(prof_region_t region, size_t line, uint16_t *bank, uint16_t *addy) {
+  size_t off = line << MEMPROF_LINE_SHIFT;
+  switch (region) {
+    case PROF_ROM:
+      *bank = (uint16_t)(off / 0x4000);
+      *addy = (uint16_t)((*bank ? 0x4000 : 0x0000) | (off & 0x3FFF));
+      return;
+    case PROF_VRAM:
+      *bank = (uint16_t)(off / 0x2000);
+      *addy = (uint16_t)(0x8000 + (off & 0x1FFF));
+      return;
+    case PROF_CART_RAM:
+      *bank = (uint16_t)(off / 0x2000);
+      *addy = (uint16_t)(0xA000 + (off & 0x1FFF));
+      return;
+    case PROF_WRAM:
+      *bank = (uint16_t)(off / 0x1000);
+      *addy = (uint16_t)((*bank ? 0xD000 : 0xC000) + (off & 0x0FFF));
+      return;
+    case PROF_OAM:
+      *bank = 0;
+      *addy = (uint16_t)(0xFE00 + off);
+      return;
+    case PROF_IO:
+      *bank = 0;
+      *addy = (uint16_t)(0xFF00 + line);
+      return;
+    case PROF_MBC:
+    case PROF_OTHER:
+    default:
+      *bank = 0;
+      *addy = (uint16_t)off;
+      return;
+  }
+}
+
+// Flattens every touched line into a freshly allocated array.
+static size_t collect_hot(Mem_Prof_t *p, Mem_Hot_t **out) {
+  struct { prof_region_t region; Mem_Count_t *lines; size_t count; } regions[] = {
+    { PROF_ROM, p->rom, p->rom ? p->rom_lines : 0 },
+    { PROF_MBC, p->mbc, sizeof(p->mbc) / sizeof(p->mbc[0]) },
+    { PROF_VRAM, p->vram, sizeof(p->vram) / sizeof(p->vram[0]) },
+    { PROF_CART_RAM, p->cart_ram, p->cart_ram ? p->cart_ram_lines : 0 },
+    { PROF_WRAM, p->wram, sizeof(p->wram) / sizeof(p->wram[0]) },
+    { PROF_OAM, p->oam, sizeof(p->oam) / sizeof(p->oam[0]) },
+    { PROF_IO, p->io, sizeof(p->io) / sizeof(p->io[0]) },
+    { PROF_OTHER, p->other, sizeof(p->other) / sizeof(p->other[0]) },
+  };
+
+  size_t used = 0, cap = 256;
+  Mem_Hot_t *hot = (Mem_Hot_t*)malloc(cap * sizeof(Mem_Hot_t));
+  if (!hot) return 0;
+
+  for (size_t r = 0; r < sizeof(regions) / sizeof(regions[0]); r++) {
+    for (size_t i = 0; i < regions[r].count; i++) {
+      Mem_Count_t c = regions[r].lines[i];
+      if (!c.reads && !c.writes) continue;
+      if (used == cap) {
+        Mem_Hot_t *grown = (Mem_Hot_t*)realloc(hot, cap * 2 * sizeof(Mem_Hot_t));
+        if (!grown) break;
+        hot = grown;
+        cap *= 2;
+      }
+      hot[used].region = regions[r].region;
+      hot[used].count = c;
+      line_location(regions[r].region, i, &hot[used].bank, &hot[used].addy);
+      used++;
+    }
+  }
+  *out = hot;
+  return used;
+}
+
+static int hot_cmp(const void *a, const void *b) {
+  const Mem_Hot_t *x = (const Mem_Hot_t*)a;
+  const Mem_Hot_t *y = (const Mem_Hot_t*)b;
+  uint64_t tx = (uint64_t)x->count.reads + x->count.writes;
+  uint64_t ty = (uint64_t)y->count.reads + y->count.writes;
+  return (tx < ty) - (tx > ty);
+}
+
+int memprof_write_heatmap(Bus_t *bus, const char *filename) {
+  if (!bus->prof) return -1;
+
+  FILE *f = fopen(filename, "w");
+  if (!f) {
+    fprintf(stderr, "[PROF] failed to open %s\n", filename);
+    return -1;
+  }
+  Mem_Hot_t *hot = NULL;
+  size_t n = collect_hot(bus->prof, &hot);
+
+  fprintf(f, "region,bank,address,reads,writes\n");
+  for (size_t i = 0; i < n; i++) {
+    fprintf(f, "%s,%u,0x%04X,%u,%u\n", region_names[hot[i].region],
+            hot[i].bank, hot[i].addy, hot[i].count.reads, hot[i].count.writes);
+  }
+  free(hot);
+  fclose(f);
+  return 0;
+}
+
+void memprof_summary(Bus_t *bus, FILE *out, int top_n) {
+  if (!bus->prof) return;
+
+  Mem_Hot_t *hot = NULL;
+  size_t n = collect_hot(bus->prof, &hot);
+  qsort(hot, n, sizeof(Mem_Hot_t), hot_cmp);
+
+  fprintf(out, "[PROF] top %d lines\n", top_n);
+  for (size_t i = 0; i < n && (int)i < top_n; i++) {
+    fprintf(out, "  %-8s bank %3u  %04X  r=%-10u w=%u\n", region_names[hot[i].region],
+            hot[i].bank, hot[i].addy, hot[i].count.reads, hot[i].count.writes);
+  }
+  fprintf(out, "[PROF] I/O registers\n");
+  for (size_t i = 0; i < n; i++) {
+    if (hot[i].region != PROF_IO || hot[i].addy >= 0xFF80) continue;
+    fprintf(out, "  FF%02X  r=%-10u w=%u\n", hot[i].addy & 0xFF,
+            hot[i].count.reads, hot[i].count.writes);
+  }
+  free(hot);
+}
+
+void memprof_free(Bus_t *bus) {
+  if (!bus->prof) return;
+  free(bus->prof->rom);
+  free(bus->prof->cart_ram);
+  free(bus->prof);
+  bus->prof = NULL;
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "memview.h"
+#include "memory.h"
+#include "mbc.h"
+
+uint16_t bus_mem_bank_count(Bus_t *bus, mem_region_t region) {
+  Cartridge_t *cart = bus->cartridge;
+  switch (region) {
+    case MEM_WRAM: return 8;
+    case MEM_VRAM: return 2;
+    case MEM_OAM:  return 1;
+    case MEM_HRAM: return 1;
+    case MEM_CART_RAM:
+      if (!cart || !cart->ram || !cart->ram_size) return 0;
+      return cart->ram_banks ? cart->ram_banks : 1;
+    case MEM_ROM:
+      return cart ? cart->rom_banks : 0;
+    default:
+      return 0;
+  }
+}
+
+bool bus_mem_view(Bus_t *bus, mem_region_t region, uint16_t bank, Mem_View_t *out) {
+  if (bank >= bus_mem_bank_count(bus, region)) return false;
+
+  Cartridge_t *cart = bus->cartridge;
+  out->region = region;
+  out->bank = bank;
+
+  switch (region) {
+    case MEM_WRAM:
+      out->data = &bus->wram[bank * 0x1000];
+      out->size = 0x1000;
+      out->addy = bank ? 0xD000 : 0xC000;
+      return true;
+    case MEM_VRAM:
+      out->data = &bus->vram[bank * 0x2000];
+      out->size = 0x2000;
+      out->addy = 0x8000;
+      return true;
+    case MEM_OAM:
+      out->data = bus->oam;
+      out->size = sizeof(bus->oam);
+      out->addy = 0xFE00;
+      return true;
+    case MEM_HRAM:
+      out->data = bus->hram;
+      out->size = sizeof(bus->hram);
+      out->addy = 0xFF80;
+      return true;
+    case MEM_CART_RAM: {
+      size_t off = (size_t)bank * 0x2000u;
+      out->data = cart->ram + off;
+      out->size = (cart->ram_size - off < 0x2000u) ? cart->ram_size - off : 0x2000u;
+      out->addy = 0xA000;
+      return true;
+    }
+    case MEM_ROM:
+      out->data = cart->rom_map[bank];
+      out->size = 0x4000;
+      out->addy = bank ? 0x4000 : 0x0000;
+      return true;
+    default:
+      return false;
+  }
+}
+
+size_t bus_mem_views(Bus_t *bus, Mem_View_t *out, size_t max) {
+  size_t n = 0;
+  for (int r = 0; r < MEM_REGION_COUNT; r++) {
+    uint16_t banks = bus_mem_bank_count(bus, (mem_region_t)r);
+    for (uint16_t b = 0; b < banks; b++, n++) {
+      if (n < max) bus_mem_view(bus, (mem_region_t)r, b, &out[n]);
+    }
+  }
+  return n;
+}
@@ -1,10 +1,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "ppu.h"
 #include "memory.h"
 #include "mbc.h"
 #include "logging.h"
+#include "cheats.h"
+#include "save.h"
 
 
 uint32_t bw_palette[4] = {
@@ -18,18 +21,32 @@ uint32_t sgb_palette[4] = {
     0x000000 
 };
 
-static inline uint8_t read_vram_bank(Bus_t *bus, uint16_t addr, uint8_t bank) {
-  uint16_t offset = addr - 0x8000;
-  uint16_t real_addr = offset + (bank * 0x2000);
-  if (real_addr >= 0x4000) return 0xFF;
-  return bus->vram[real_addr];
+static uint32_t lcd_lut[0x8000];
+static pthread_once_t lcd_lut_once = PTHREAD_ONCE_INIT;
+
+// Channel mixing of the CGB LCD, r/g/b 0-31 in, 8 bits out
+static void build_lcd_lut(void) {
+  for (uint32_t c = 0; c < 0x8000; c++) {
+    uint32_t r = c & 0x1F;
+    uint32_t g = (c >> 5) & 0x1F;
+    uint32_t b = (c >> 10) & 0x1F;
+
+    uint32_t R = r * 26 + g * 4 + b * 2;
+    uint32_t G = g * 24 + b * 8;
+    uint32_t B = r * 6 + g * 4 + b * 22;
+    if (R > 960) R = 960;
+    if (G > 960) G = 960;
+    if (B > 960) B = 960;
+    lcd_lut[c] = ((R >> 2) << 16) | ((G >> 2) << 8) | (B >> 2);
+  }
 }
 
-static inline uint32_t cgb_2_rgb(uint8_t *pallete, uint8_t pallete_num, uint8_t color_id) {
+static inline uint32_t cgb_2_rgb(const Ppu_t *d, const uint8_t *pallete, uint8_t pallete_num, uint8_t color_id) {
   int offset = (pallete_num * 8) + (color_id * 2);
   
   uint16_t rgb555 = pallete[offset] | (pallete[offset + 1] << 8);
-  
+  if (d->color_correct)
+    return lcd_lut[rgb555 & 0x7FFF];
   
   uint8_t r = (rgb555 & 0x1F);           
   uint8_t g = (rgb555 >> 5) & 0x1F;     
@@ -80,11 +97,140 @@ static void init_default_palettes(Ppu_t *display) {
   }
 }
 
+void ppu_update_dmg_colors(Ppu_t *d) {
+  if (d->bus->is_cgb) return;
+
+  for (int id = 0; id < 4; id++) {
+    d->colors[id] = d->pallete[(d->BGP >> (id * 2)) & 3];
+    d->colors[4 + id] = d->pallete[0]; // BG disabled
+    d->colors[COMPOSE_OBJ_SLOT + id] = d->pallete[(d->OBP0 >> (id * 2)) & 3];
+    d->colors[COMPOSE_OBJ_SLOT + 4 + id] = d->pallete[(d->OBP1 >> (id * 2)) & 3];
+  }
+  d->palette_version++;
+}
+
+// index is the palette RAM byte (0-63) that was written
+void ppu_update_cgb_color(Ppu_t *d, bool obj, uint8_t index) {
+  if (!d->bus->is_cgb) return;
+
+  uint8_t pal = (index & 0x3F) >> 3;
+  uint8_t id = (index >> 1) & 3;
+  int slot = (obj ? COMPOSE_OBJ_SLOT : 0) + pal * 4 + id;
+  d->colors[slot] = cgb_2_rgb(d, obj ? d->obj_pallete : d->bg_pallete, pal, id);
+  d->palette_version++;
+}
+
+static void refresh_colors(Ppu_t *d) {
+  if (!d->bus->is_cgb) {
+    ppu_update_dmg_colors(d);
+    return;
+  }
+  for (int i = 0; i < 64; i += 2) {
+    ppu_update_cgb_color(d, false, (uint8_t)i);
+    ppu_update_cgb_color(d, true, (uint8_t)i);
+  }
+}
+
+void ppu_set_color_correction(Ppu_t *d, bool enable) {
+  if (enable) pthread_once(&lcd_lut_once, build_lcd_lut);
+  d->color_correct = enable;
+  refresh_colors(d);
+}
+
+size_t ppu_output_size(Ppu_Format_t format) {
+  switch (format) {
+    case PPU_FORMAT_ARGB8888: return GB_WIDTH * GB_HEIGHT * 4;
+    case PPU_FORMAT_RGB565: return GB_WIDTH * GB_HEIGHT * 2;
+    case PPU_FORMAT_INDEXED:
+    case PPU_FORMAT_GRAY8: return GB_WIDTH * GB_HEIGHT;
+    case PPU_FORMAT_GRAY_SMALL: return PPU_GRAY_SMALL_SIZE * PPU_GRAY_SMALL_SIZE;
+  }
+  return 0;
+}
+
+// Makes frames[index] the one being drawn
+static void set_back_frame(Ppu_t *d, int index) {
+  d->frame_back = (uint8_t)index;
+  d->output = d->frames[index];
+  d->framebuffer = d->format == PPU_FORMAT_ARGB8888 ? (uint32_t*)d->output : NULL;
+  d->gray_lines = d->gray_frames ? d->gray_frames + (size_t)index * GB_WIDTH * GB_HEIGHT : NULL;
+}
+
+// VBlank of a drawn frame: hand the back buffer over and take whichever
+// frame the consumer isn't holding
+static void publish_frame(Ppu_t *d) {
+  uint8_t old = __atomic_exchange_n(&d->frame_shared, (uint8_t)(d->frame_back | PPU_FRAME_FRESH),
+                                    __ATOMIC_ACQ_REL);
+  set_back_frame(d, old & ~PPU_FRAME_FRESH);
+}
+
+int ppu_set_format(Ppu_t *d, Ppu_Format_t format) {
+  void *frames[PPU_FRAME_BUFFERS];
+  uint8_t *gray = NULL;
+  bool ok = true;
+
+  if (d->render) {
+    // the render thread draws into the current frames
+    fprintf(stderr, "[PPU] stop the render thread before changing the output format\n");
+    return -1;
+  }
+
+  for (int i = 0; i < PPU_FRAME_BUFFERS; i++) {
+    frames[i] = calloc(1, ppu_output_size(format));
+    ok = ok && frames[i];
+  }
+  if (format == PPU_FORMAT_GRAY_SMALL) {
+    gray = (uint8_t*)calloc(PPU_FRAME_BUFFERS, GB_WIDTH * GB_HEIGHT);
+    ok = ok && gray;
+  }
+  if (!ok) {
+    fprintf(stderr, "[PPU] out of memory for output format %d\n", (int)format);
+    for (int i = 0; i < PPU_FRAME_BUFFERS; i++) free(frames[i]);
+    free(gray);
+    return -1;
+  }
+
+  for (int i = 0; i < PPU_FRAME_BUFFERS; i++) {
+    free(d->frames[i]);
+    d->frames[i] = frames[i];
+  }
+  free(d->gray_frames);
+  d->gray_frames = gray;
+  d->format = format;
+  d->frame_front = 0;
+  d->frame_shared = 1;
+  set_back_frame(d, 2);
+  d->small_dirty = false;
+  d->out_lut_version = d->palette_version - 1;
+  // rows of the new buffers were never drawn
+  memset(d->line_sig, 0, sizeof(d->line_sig));
+  return 0;
+}
+
+const uint32_t *ppu_output_palette(const Ppu_t *d, int *count) {
+  if (d->bus->is_cgb) {
+    *count = 128;
+    return d->colors;
+  }
+  *count = 4;
+  return d->pallete;
+}
+
+void ppu_set_frame_skip(Ppu_t *d, int render_every) {
+  d->render_every = render_every < 0 ? 0 : render_every;
+  d->frame_count = 0;
+  d->skip_frame = !d->render_every;
+}
+
 void start_display(Ppu_t *display, Bus_t *bus, int scale) {
   memset(display, 0, sizeof(Ppu_t));
   display->bus = bus;
+  display->oam_version = 1; // sprite lists start stale
+  display->render_every = 1;
 
   display->LCDC = 0x91;
+  display->STAT = 2;
+  display->next_event = 80;
   display->SCY = 0;
   display->SCX = 0;
   display->LY = 0;
@@ -113,18 +259,101 @@ void start_display(Ppu_t *display, Bus_t *bus, int scale) {
   for (int i = 0; i <= 3; i++) {
     display->pallete[i] = palette_to_use[i];
   }
+  refresh_colors(display);
 
-  display->framebuffer = (uint32_t*)calloc(GB_WIDTH*GB_HEIGHT, 4);
+  ppu_set_format(display, PPU_FORMAT_ARGB8888);
   display->background_buffer = (uint32_t*)calloc(256*256, 4);
-  if (scale <= 1) {
-    display->scaled_framebuffer = display->framebuffer;
-  } else {
+  display->tiles = (Tile_Cache_t*)calloc(1, sizeof(Tile_Cache_t));
+  if (scale > 1)
     display->scaled_framebuffer = (uint32_t*)calloc(GB_WIDTH*GB_HEIGHT, 4*scale*scale);
+}
+
+static void decode_tile(Ppu_t *d, int bank, uint16_t tile) {
+  const uint8_t *src = &d->bus->vram[bank * 0x2000 + tile * 16];
+  uint8_t (*px)[8][8] = d->tiles->px[bank][tile];
+
+  for (int row = 0; row < 8; row++) {
+    uint8_t low = src[row * 2];
+    uint8_t high = src[row * 2 + 1];
+    for (int col = 0; col < 8; col++) {
+      int bit = 7 - col;
+      uint8_t id = (uint8_t)(((high >> bit) & 1) << 1 | ((low >> bit) & 1));
+      px[0][row][col] = id;
+      px[1][row][7 - col] = id;
+    }
+  }
+  d->tiles->valid[bank][tile >> 6] |= 1ull << (tile & 63);
+}
+
+// Eight color ids for one row of a tile, left to right as drawn
+static inline const uint8_t *tile_row(Ppu_t *d, int bank, uint16_t tile, int row, bool flip_x) {
+  if (!((d->tiles->valid[bank][tile >> 6] >> (tile & 63)) & 1))
+    decode_tile(d, bank, tile);
+  return d->tiles->px[bank][tile][flip_x][row];
+}
+
+// Drops the cached tile and bumps the version the line signatures see
+static inline void vram_changed(Ppu_t *d, uint16_t addr) {
+  uint16_t off = addr & 0x1FFF;
+  if (off >= TILE_COUNT * 16) {
+    d->map_row_version[(off >> 10) & 1][(off >> 5) & 31]++;
+    return;
   }
+  uint16_t tile = off >> 4;
+  d->tiles->valid[addr >> 13][tile >> 6] &= ~(1ull << (tile & 63));
+  d->tile_block_version[off >> 11]++;
 }
 
-static uint8_t bg_tile_attrs[GB_WIDTH];
-static uint8_t bg_color_ids[GB_WIDTH];
+// Index into the tile cache for a BG/window tile number
+static inline uint16_t bg_tile_index(const Ppu_t *d, uint8_t tile_num) {
+  if (d->LCDC & 0x10) return tile_num;
+  return (uint16_t)(256 + (int8_t)tile_num); // 0x8800 mode, signed from 0x9000
+}
+
+// Decoded row of a BG/window tile, with CGB bank and flip attributes
+static inline const uint8_t *bg_row(Ppu_t *d, uint8_t tile_num, uint8_t tile_attr, int map_y) {
+  int line = map_y & 7;
+  if (tile_attr & 0x40) line = 7 - line;
+  return tile_row(d, (tile_attr & 0x08) ? 1 : 0, bg_tile_index(d, tile_num), line,
+                  (tile_attr & 0x20) != 0);
+}
+
+// Fills the BG layer from map entry (map_x, map_y) onwards for columns
+// x..end-1, starting fine pixels into the first tile. Map entries and
+// attributes come straight from VRAM banks 0 and 1: the PPU is not
+// subject to the CPU's VBK selection or OAM DMA bus lockout.
+static void render_tile_span(Ppu_t *d, uint16_t map_addr, int map_x, int map_y,
+                             int fine, int x, int end) {
+  const uint8_t *map = &d->bus->vram[(map_addr - 0x8000) + (map_y / 8) * 32];
+  const uint8_t *attrs = map + 0x2000;
+  bool cgb = d->bus->is_cgb;
+
+  // Partial first tile
+  if (fine) {
+    uint8_t tile_attr = cgb ? attrs[map_x & 31] : 0;
+    const uint8_t *row = bg_row(d, map[map_x & 31], tile_attr, map_y);
+    int n = 8 - fine;
+    if (n > end - x) n = end - x;
+    memcpy(&d->line.bg_id[x], row + fine, n);
+    memset(&d->line.bg_attr[x], tile_attr, n);
+    x += n;
+    map_x++;
+  }
+
+  // Whole tiles, at most 20 per line
+  for (; x + 8 <= end; x += 8, map_x++) {
+    uint8_t tile_attr = cgb ? attrs[map_x & 31] : 0;
+    memcpy(&d->line.bg_id[x], bg_row(d, map[map_x & 31], tile_attr, map_y), 8);
+    memset(&d->line.bg_attr[x], tile_attr, 8);
+  }
+
+  // Partial last tile
+  if (x < end) {
+    uint8_t tile_attr = cgb ? attrs[map_x & 31] : 0;
+    memcpy(&d->line.bg_id[x], bg_row(d, map[map_x & 31], tile_attr, map_y), end - x);
+    memset(&d->line.bg_attr[x], tile_attr, end - x);
+  }
+}
 
 static void hdma_transfer1(Ppu_t *d, Bus_t *b) {
   if (!d->hdma_active || !b || !b->cartridge) return;
@@ -134,20 +363,10 @@ static void hdma_transfer1(Ppu_t *d, Bus_t *b) {
     return;
   }
 
-  uint16_t src = d->hdma_src;
-  uint16_t dst = d->hdma_dst;
-
-  for (int i = 0; i < 0x10; i++) {
-    uint8_t val = read_byte_bus(b, src++);
-    // Destination is always in VRAM region 0x8000-0x9FF0
-    if (dst >= 0x8000 && dst < 0xA000) {
-      write_byte_bus(b, dst, val);
-    }
-    dst++;
-  }
-
-  d->hdma_src = src;
-  d->hdma_dst = dst;
+  bus_vram_dma(b, d->hdma_src, d->hdma_dst, 0x10);
+  d->hdma_src += 0x10;
+  d->hdma_dst += 0x10;
+  d->hdma_stall += 32;
 
   if (d->hdma_remaining <= 0x10) {
     d->hdma_remaining = 0;
@@ -165,249 +384,861 @@ static void render_bg_scanline(Ppu_t *d) {
   if (!d->bus->is_cgb && !(d->LCDC & 0x01))
     return;
 
-  uint16_t tile_data_addr = (d->LCDC & 0x10) ? 0x8000 : 0x8800;
   uint16_t bg_map_addr = (d->LCDC & 0x08) ? 0x9C00 : 0x9800;
-
   int y = (d->SCY + d->LY) & 0xFF;
 
-  for (int x = 0; x < GB_WIDTH; x++) {
-    int scx = (d->SCX + x) & 0xFF;
-    uint16_t map_index = bg_map_addr + ((y / 8) * 32) + (scx / 8);
-    uint8_t tile_num = read_byte_bus(d->bus, map_index);
+  render_tile_span(d, bg_map_addr, d->SCX / 8, y, d->SCX % 8, 0, GB_WIDTH);
+}
+
+static void render_window_scanline(Ppu_t *d) {
+  if (!(d->LCDC & 0x20))
+    return;
+
+  if (d->WY > d->LY)
+    return;
+
+  uint16_t win_map_addr = (d->LCDC & 0x40) ? 0x9C00 : 0x9800;
+  int win_y = d->LY - d->WY;
+
+  // WX < 7 starts the window partway into its first tile
+  int start = d->WX - 7;
+  int fine = 0;
+  if (start < 0) {
+    fine = -start;
+    start = 0;
+  }
+  if (start >= GB_WIDTH)
+    return;
+
+  render_tile_span(d, win_map_addr, fine / 8, win_y, fine % 8, start, GB_WIDTH);
+}
+
+// OAM scan for the whole frame. Work is 40 entries plus the lines each
+// visible sprite covers.
+static void build_sprite_lists(Ppu_t *d, int height) {
+  Sprite_Lists_t *s = &d->sprites;
+  const uint8_t *oam = d->bus->oam;
+  bool x_priority = !d->bus->is_cgb;
+
+  memset(s->count, 0, sizeof(s->count));
+  for (int i = 0; i < 40; i++) {
+    int top = oam[i * 4] - 16;
+    int bottom = top + height;
+    if (top < 0) top = 0;
+    if (bottom > GB_HEIGHT) bottom = GB_HEIGHT;
+
+    for (int y = top; y < bottom; y++) {
+      uint8_t n = s->count[y];
+      if (n >= SPRITES_PER_LINE) continue;
+
+      // DMG: smaller X wins, ties go to the lower OAM index
+      int at = n;
+      if (x_priority) {
+        while (at > 0 && oam[s->index[y][at - 1] * 4 + 1] > oam[i * 4 + 1]) {
+          s->index[y][at] = s->index[y][at - 1];
+          at--;
+        }
+      }
+      s->index[y][at] = (uint8_t)i;
+      s->count[y] = n + 1;
+    }
+  }
+  s->version = d->oam_version;
+  s->height = (uint8_t)height;
+}
+
+static inline void update_sprite_lists(Ppu_t *d) {
+  int height = (d->LCDC & 0x04) ? 16 : 8;
+  if (d->sprites.version != d->oam_version || d->sprites.height != height)
+    build_sprite_lists(d, height);
+}
+
+static void render_sprites_scanline(Ppu_t *d) {
+  if (!(d->LCDC & 0x02))
+    return;
 
-    uint8_t tile_attr = 0;
+  int sprite_height = (d->LCDC & 0x04) ? 16 : 8;
+  update_sprite_lists(d);
+
+  int n = d->sprites.count[d->LY];
+  for (int i = 0; i < n; i++) {
+    const uint8_t *oam = &d->bus->oam[d->sprites.index[d->LY][i] * 4];
+    uint8_t tile_num = oam[2];
+    uint8_t attributes = oam[3];
+    int sprite_x = oam[1] - 8;
+    if (sprite_x <= -8 || sprite_x >= GB_WIDTH) continue;
+
+    // CGB palette 0-7, DMG OBP0/OBP1
+    uint8_t sprite_palette = (attributes & 0x10) ? 1 : 0;
     if (d->bus->is_cgb) {
-      tile_attr = read_vram_bank(d->bus, map_index, 1);
+      sprite_palette = attributes & 0x07;
     }
 
-    uint16_t tile_addr;
-    if (d->LCDC & 0x10)
-      tile_addr = tile_data_addr + (tile_num * 16);
-    else
-      tile_addr = tile_data_addr + ((int8_t)tile_num + 128) * 16;
+    int line = d->LY - (oam[0] - 16);
+    if (attributes & 0x40)
+      line = sprite_height - 1 - line;
 
-    int line = y % 8;
-    if (d->bus->is_cgb && (tile_attr & 0x40)) {
-      line = 7 - line;
+    if (sprite_height == 16) {
+      tile_num &= 0xFE;
+      if (line >= 8) {
+        tile_num |= 0x01;
+        line -= 8;
+      }
     }
 
-    uint8_t low, high;
-    if (d->bus->is_cgb && (tile_attr & 0x08)) {
-      low = read_vram_bank(d->bus, tile_addr + (line * 2), 1);
-      high = read_vram_bank(d->bus, tile_addr + (line * 2) + 1, 1);
-    } else {
-      low = read_vram_bank(d->bus, tile_addr + (line * 2), 0);
-      high = read_vram_bank(d->bus, tile_addr + (line * 2) + 1, 0);
+    int bank = (d->bus->is_cgb && (attributes & 0x08)) ? 1 : 0;
+    const uint8_t *row = tile_row(d, bank, tile_num, line, (attributes & 0x20) != 0);
+
+    uint8_t obj_attr = sprite_palette | ((attributes & 0x80) ? COMPOSE_OBJ_BEHIND : 0);
+    int px = sprite_x < 0 ? -sprite_x : 0;
+    int end = sprite_x + 8 > GB_WIDTH ? GB_WIDTH - sprite_x : 8;
+    for (; px < end; px++) {
+      int screen_x = sprite_x + px;
+      // list is in priority order, so the first opaque pixel stays
+      if (row[px] && !d->line.obj_id[screen_x]) {
+        d->line.obj_id[screen_x] = row[px];
+        d->line.obj_attr[screen_x] = obj_attr;
+      }
     }
+  }
+}
 
-    int bit = 7 - (scx % 8);
-    if (d->bus->is_cgb && (tile_attr & 0x20)) {
-      bit = scx % 8;
+static inline uint64_t sig_mix(uint64_t h, uint64_t v) {
+  h = (h ^ v) * 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 29);
+}
+
+// Hash of everything render_scanline reads for the current line. Never 0,
+// which marks a row that was never drawn.
+static uint64_t line_signature(Ppu_t *d) {
+  uint8_t lcdc = d->LCDC;
+  int y = (d->SCY + d->LY) & 0xFF;
+
+  uint64_t h = sig_mix(0, lcdc | (uint32_t)d->SCX << 8 | (uint32_t)y << 16 |
+                          (uint64_t)d->palette_version << 24);
+  h = sig_mix(h, d->map_row_version[(lcdc >> 3) & 1][y >> 3]);
+  h = sig_mix(h, (uint64_t)d->tile_block_version[1] << 32 |
+                 d->tile_block_version[(lcdc & 0x10) ? 0 : 2]);
+
+  if ((lcdc & 0x20) && d->WY <= d->LY && d->WX < GB_WIDTH + 7) {
+    int win_y = d->LY - d->WY;
+    h = sig_mix(h, d->WX | win_y << 8);
+    h = sig_mix(h, d->map_row_version[(lcdc >> 6) & 1][win_y >> 3]);
+  }
+
+  if (lcdc & 0x02) {
+    update_sprite_lists(d);
+    h = sig_mix(h, d->tile_block_version[0]);
+    for (int i = 0; i < d->sprites.count[d->LY]; i++) {
+      uint8_t index = d->sprites.index[d->LY][i];
+      uint32_t entry;
+      memcpy(&entry, &d->bus->oam[index * 4], 4);
+      h = sig_mix(h, (uint64_t)index << 32 | entry);
     }
+  }
+  return h | 1;
+}
+
+// DMG shade (0-3) a compose slot ends up as
+static inline uint8_t dmg_shade(const Ppu_t *d, int slot) {
+  int id = slot & 3;
+  if (slot >= COMPOSE_OBJ_SLOT)
+    return (((slot & 4) ? d->OBP1 : d->OBP0) >> (id * 2)) & 3;
+  if (slot & 4) return 0; // BG disabled
+  return (d->BGP >> (id * 2)) & 3;
+}
 
-    int color_id = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+static void update_output_luts(Ppu_t *d) {
+  if (d->out_lut_version == d->palette_version) return;
+  d->out_lut_version = d->palette_version;
 
-    bg_tile_attrs[x] = tile_attr;
-    bg_color_ids[x] = color_id;
+  for (int slot = 0; slot < 128; slot++) {
+    uint32_t c = d->colors[slot];
+    uint8_t r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+    d->out_lut16[slot] = (uint16_t)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+    if (d->format == PPU_FORMAT_INDEXED)
+      d->out_lut8[slot] = d->bus->is_cgb ? (uint8_t)slot : dmg_shade(d, slot);
+    else
+      d->out_lut8[slot] = (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+  }
+}
 
-    uint32_t color;
-    if (d->bus->is_cgb) {
-      uint8_t palette_num = tile_attr & 0x07;
-      color = cgb_2_rgb(d->bg_pallete, palette_num, color_id);
-    } else {
-      color = d->pallete[(d->BGP >> (color_id * 2)) & 3];
+// Writes line LY of a non-ARGB output from its compose slots
+static void emit_line(Ppu_t *d, const uint8_t *slots) {
+  update_output_luts(d);
+  size_t row = (size_t)d->LY * GB_WIDTH;
+
+  switch (d->format) {
+    case PPU_FORMAT_RGB565: {
+      uint16_t *out = (uint16_t*)d->output + row;
+      for (int x = 0; x < GB_WIDTH; x++) out[x] = d->out_lut16[slots[x]];
+      break;
+    }
+    case PPU_FORMAT_INDEXED:
+    case PPU_FORMAT_GRAY8: {
+      uint8_t *out = (uint8_t*)d->output + row;
+      for (int x = 0; x < GB_WIDTH; x++) out[x] = d->out_lut8[slots[x]];
+      break;
+    }
+    case PPU_FORMAT_GRAY_SMALL: {
+      uint8_t *out = d->gray_lines + row;
+      for (int x = 0; x < GB_WIDTH; x++) out[x] = d->out_lut8[slots[x]];
+      d->small_dirty = true;
+      break;
     }
-    d->framebuffer[d->LY * GB_WIDTH + x] = 0xFF000000 | color;
+    default:
+      break;
   }
 }
 
-static void render_window_scanline(Ppu_t *d) {
-  if (!(d->LCDC & 0x20))
-    return;
+// Box filter for PPU_FORMAT_GRAY_SMALL. Output row ty averages lines
+// ceil(ty * 144 / 84) up to ceil((ty + 1) * 144 / 84), and is written
+// on the last of them if any was redrawn.
+static void finish_small_row(Ppu_t *d) {
+  const int n = PPU_GRAY_SMALL_SIZE;
+  int ty = d->LY * n / GB_HEIGHT;
+  int y0 = (ty * GB_HEIGHT + n - 1) / n;
+  int y1 = ((ty + 1) * GB_HEIGHT + n - 1) / n;
+  if (d->LY != y1 - 1 || !d->small_dirty) return;
+  d->small_dirty = false;
+
+  uint8_t *out = (uint8_t*)d->output + ty * n;
+  for (int tx = 0; tx < n; tx++) {
+    int x0 = (tx * GB_WIDTH + n - 1) / n;
+    int x1 = ((tx + 1) * GB_WIDTH + n - 1) / n;
+    int sum = 0;
+    for (int y = y0; y < y1; y++) {
+      const uint8_t *src = d->gray_lines + y * GB_WIDTH;
+      for (int x = x0; x < x1; x++) sum += src[x];
+    }
+    int count = (y1 - y0) * (x1 - x0);
+    out[tx] = (uint8_t)((sum + count / 2) / count);
+  }
+}
 
-  if (d->WY > d->LY)
+static void draw_line(Ppu_t *d) {
+  memset(d->line.bg_id, 0, sizeof(d->line.bg_id));
+  // DMG with BG off shows plain color 0, kept in BG palette 1
+  memset(d->line.bg_attr, (!d->bus->is_cgb && !(d->LCDC & 0x01)) ? 1 : 0, sizeof(d->line.bg_attr));
+  memset(d->line.obj_id, 0, sizeof(d->line.obj_id));
+
+  render_bg_scanline(d);
+  render_window_scanline(d);
+  render_sprites_scanline(d);
+
+  if (d->format == PPU_FORMAT_ARGB8888) {
+    compose_line(&d->line, d->bus->is_cgb, (d->LCDC & 0x01) != 0, d->colors,
+                 &d->framebuffer[d->LY * GB_WIDTH]);
     return;
+  }
+  uint8_t slots[GB_WIDTH];
+  compose_line_slots(&d->line, d->bus->is_cgb, (d->LCDC & 0x01) != 0, slots);
+  emit_line(d, slots);
+}
 
-  uint16_t tile_data_addr = (d->LCDC & 0x10) ? 0x8000 : 0x8800;
-  uint16_t win_map_addr = (d->LCDC & 0x40) ? 0x9C00 : 0x9800;
-  int win_y = d->LY - d->WY;
+static void render_scanline(Ppu_t *d) {
+  uint64_t sig = line_signature(d);
+  uint64_t *drawn = &d->line_sig[d->frame_back][d->LY];
+  if (sig != *drawn) {
+    *drawn = sig;
+    d->lines_rendered++;
+    draw_line(d);
+  } else {
+    d->lines_reused++;
+  }
+  if (d->format == PPU_FORMAT_GRAY_SMALL)
+    finish_small_row(d);
+}
+
+// OAM scan for one line, used by the FIFO backend at the end of mode 2
+static void fifo_scan_oam(Ppu_t *d) {
+  Ppu_Fifo_t *f = &d->fifo;
+  int height = (d->LCDC & 0x04) ? 16 : 8;
+
+  f->sprite_count = 0;
+  f->sprite_done = 0;
+  for (int i = 0; i < 40 && f->sprite_count < SPRITES_PER_LINE; i++) {
+    int top = d->bus->oam[i * 4] - 16;
+    if (d->LY >= top && d->LY < top + height)
+      f->sprite[f->sprite_count++] = (uint8_t)i;
+  }
+}
 
-  for (int x = 0; x < GB_WIDTH; x++) {
-    int win_x = x - (d->WX - 7);
+static void fifo_start_line(Ppu_t *d) {
+  Ppu_Fifo_t *f = &d->fifo;
 
-    if (win_x < 0)
-      continue;
+  if (d->LY == 0) {
+    f->wy_hit = false;
+    f->win_line = 0;
+  }
+  if (d->LY == d->WY) f->wy_hit = true;
+
+  f->bg_len = 0;
+  memset(f->obj_id, 0, sizeof(f->obj_id));
+  f->obj_head = 0;
+  f->fetch_dot = 0;
+  f->fetch_x = 0;
+  f->discard = d->SCX & 7;
+  f->x = 0;
+  f->stall = 6; // the first tile is fetched twice
+  f->in_window = false;
+  f->drawing = true;
+  fifo_scan_oam(d);
+}
 
-    uint16_t map_index = win_map_addr + ((win_y / 8) * 32) + (win_x / 8);
-    uint8_t tile_num = read_byte_bus(d->bus, map_index);
+// Merges one sprite row into the OBJ FIFO. Opaque pixels already there
+// win, except that on CGB a lower OAM index takes over.
+static void fifo_fetch_sprite(Ppu_t *d, uint8_t index) {
+  Ppu_Fifo_t *f = &d->fifo;
+  const uint8_t *oam = &d->bus->oam[index * 4];
+  int height = (d->LCDC & 0x04) ? 16 : 8;
+  uint8_t attributes = oam[3];
+  bool cgb = d->bus->is_cgb;
+
+  int line = d->LY - (oam[0] - 16);
+  if (line < 0 || line >= height) return;
+  if (attributes & 0x40) line = height - 1 - line;
+
+  uint8_t tile_num = oam[2];
+  if (height == 16) {
+    tile_num &= 0xFE;
+    if (line >= 8) {
+      tile_num |= 0x01;
+      line -= 8;
+    }
+  }
 
-    uint8_t tile_attr = 0;
-    if (d->bus->is_cgb) {
-      tile_attr = read_vram_bank(d->bus, map_index, 1);
+  int bank = (cgb && (attributes & 0x08)) ? 1 : 0;
+  const uint8_t *row = tile_row(d, bank, tile_num, line, (attributes & 0x20) != 0);
+  uint8_t palette = cgb ? (attributes & 0x07) : ((attributes & 0x10) ? 1 : 0);
+  uint8_t obj_attr = palette | ((attributes & 0x80) ? COMPOSE_OBJ_BEHIND : 0);
+
+  // X < 8 is clipped at the left edge
+  int skip = oam[1] < 8 ? 8 - oam[1] : 0;
+  for (int k = skip; k < 8; k++) {
+    if (!row[k]) continue;
+    int slot = (f->obj_head + k - skip) & 7;
+    if (f->obj_id[slot] && !(cgb && index < f->obj_oam[slot])) continue;
+    f->obj_id[slot] = row[k];
+    f->obj_attr[slot] = obj_attr;
+    f->obj_oam[slot] = index;
+  }
+}
+
+// Same rules as compose_line, for a single pixel with the palettes as
+// they are at this dot
+static inline void fifo_output(Ppu_t *d, uint8_t bg, uint8_t attr, uint8_t obj, uint8_t obj_attr) {
+  bool cgb = d->bus->is_cgb;
+  bool bg_master = (d->LCDC & 0x01) != 0;
+
+  if (!cgb && !bg_master) {
+    bg = 0;
+    attr = 1; // plain color 0, kept in colors[4..7]
+  }
+  uint8_t slot = (uint8_t)(((attr & 7) << 2) | bg);
+  uint8_t bg_mask = (!cgb || bg_master) ? 0x03 : 0;
+  bool hide = (bg & bg_mask) && ((obj_attr | (cgb ? attr : 0)) & COMPOSE_OBJ_BEHIND);
+  if (obj && (d->LCDC & 0x02) && !hide)
+    slot = (uint8_t)(COMPOSE_OBJ_SLOT | ((obj_attr & 7) << 2) | obj);
+
+  if (d->skip_frame) return;
+  if (d->format == PPU_FORMAT_ARGB8888)
+    d->framebuffer[d->LY * GB_WIDTH + d->fifo.x] = 0xFF000000 | d->colors[slot];
+  else
+    d->line_slots[d->fifo.x] = slot;
+}
+
+static void fifo_fetch_step(Ppu_t *d) {
+  Ppu_Fifo_t *f = &d->fifo;
+
+  if (f->fetch_dot < 6) {
+    f->fetch_dot++;
+    // tile number and attributes after 2 dots, row data after 6
+    if (f->fetch_dot == 2) {
+      uint16_t map;
+      int col, y;
+      if (f->in_window) {
+        map = (d->LCDC & 0x40) ? 0x1C00 : 0x1800;
+        y = f->win_line;
+        col = f->fetch_x & 31;
+      } else {
+        map = (d->LCDC & 0x08) ? 0x1C00 : 0x1800;
+        y = (d->LY + d->SCY) & 0xFF;
+        col = ((d->SCX >> 3) + f->fetch_x) & 31;
+      }
+      uint16_t at = map + (y / 8) * 32 + col;
+      f->tile_num = d->bus->vram[at];
+      f->tile_attr = d->bus->is_cgb ? d->bus->vram[0x2000 + at] : 0;
+      f->tile_y = (uint8_t)y;
     }
+  }
 
-    uint16_t tile_addr;
-    if (d->LCDC & 0x10)
-      tile_addr = tile_data_addr + (tile_num * 16);
-    else
-      tile_addr = tile_data_addr + ((int8_t)tile_num + 128) * 16;
+  if (f->fetch_dot == 6 && f->bg_len == 0) {
+    memcpy(f->bg_id, bg_row(d, f->tile_num, f->tile_attr, f->tile_y), 8);
+    memset(f->bg_attr, f->tile_attr, 8);
+    f->bg_pos = 0;
+    f->bg_len = 8;
+    f->fetch_dot = 0;
+    f->fetch_x++;
+  }
+}
+
+// One mode 3 dot. Returns true once the 160th pixel is out.
+static bool fifo_dot(Ppu_t *d) {
+  Ppu_Fifo_t *f = &d->fifo;
+
+  if (f->stall) {
+    f->stall--;
+    return false;
+  }
 
-    int line = win_y % 8;
-    if (d->bus->is_cgb && (tile_attr & 0x40)) {
-      line = 7 - line;
+  // Window: drop the BG FIFO and restart the fetcher on the window map
+  if (!f->in_window && (d->LCDC & 0x20) && f->wy_hit && f->x + 7 >= d->WX) {
+    f->in_window = true;
+    f->bg_len = 0;
+    f->fetch_dot = 0;
+    f->fetch_x = 0;
+    f->discard = d->WX < 7 ? 7 - d->WX : 0;
+  }
+
+  // Sprite fetch: 6 dots plus waiting out the BG fetch in progress. Several
+  // can be due at column 0 when clipped, smallest X goes first.
+  while ((d->LCDC & 0x02) && !f->discard) {
+    int next = -1;
+    for (int i = 0; i < f->sprite_count; i++) {
+      if ((f->sprite_done >> i) & 1) continue;
+      uint8_t oam_x = d->bus->oam[f->sprite[i] * 4 + 1];
+      if (oam_x - 8 > f->x) continue;
+      if (next < 0 || oam_x < d->bus->oam[f->sprite[next] * 4 + 1]) next = i;
     }
+    if (next < 0) break;
+
+    f->sprite_done |= (uint16_t)(1u << next);
+    if (d->bus->oam[f->sprite[next] * 4 + 1] == 0) continue;
+    fifo_fetch_sprite(d, f->sprite[next]);
+    int wait = 5 - f->fetch_dot;
+    f->stall = (uint8_t)(5 + (wait > 0 ? wait : 0));
+    return false;
+  }
+
+  if (f->bg_len) {
+    uint8_t bg = f->bg_id[f->bg_pos];
+    uint8_t attr = f->bg_attr[f->bg_pos];
+    f->bg_pos++;
+    f->bg_len--;
 
-    uint8_t low, high;
-    if (d->bus->is_cgb && (tile_attr & 0x08)) {
-      low = read_vram_bank(d->bus, tile_addr + (line * 2), 1);
-      high = read_vram_bank(d->bus, tile_addr + (line * 2) + 1, 1);
+    if (f->discard) {
+      f->discard--;
     } else {
-      low = read_vram_bank(d->bus, tile_addr + (line * 2), 0);
-      high = read_vram_bank(d->bus, tile_addr + (line * 2) + 1, 0);
+      int slot = f->obj_head;
+      fifo_output(d, bg, attr, f->obj_id[slot], f->obj_attr[slot]);
+      f->obj_id[slot] = 0;
+      f->obj_head = (f->obj_head + 1) & 7;
+      f->x++;
     }
+  }
 
-    int bit = 7 - (win_x % 8);
-    if (d->bus->is_cgb && (tile_attr & 0x20)) {
-      bit = win_x % 8;
-    }
+  fifo_fetch_step(d);
+  return f->x >= GB_WIDTH;
+}
 
-    int color_id = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+// Render thread. The emulation thread queues a job for each line to draw
+// with the registers the line renderer reads, plus OAM and the color
+// table when their versions moved. VRAM writes go to a journal that the
+// render thread replays into its own copy up to each job's position, so
+// a line sees VRAM exactly as it was when queued. The render thread draws
+// with a private Ppu_t and Bus_t, so the renderer above runs unchanged.
+#define RENDER_JOBS 256           // about 1.8 frames of lines
+#define RENDER_JOURNAL (1 << 14)  // VRAM writes, more than a full GDMA
+
+enum { JOB_LINE, JOB_FRAME_END, JOB_SYNC, JOB_STOP };
+
+typedef struct {
+  uint8_t kind;
+  uint8_t LY, LCDC, SCY, SCX, WY, WX, BGP, OBP0, OBP1;
+  bool has_oam, has_colors;
+  uint32_t journal_end;  // replay VRAM writes up to here first
+  uint32_t oam_version, palette_version;
+  uint8_t oam[OAM_SIZE];
+  uint32_t colors[128];
+} Render_Job_t;
+
+struct Ppu_Render {
+  Ppu_t ppu;  // render side state, VRAM and OAM copies in bus
+  Bus_t bus;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;  // jobs queued while the render thread slept
+  pthread_cond_t room;  // progress while the emulation thread waited
+
+  // Single producer, single consumer rings. Heads belong to the
+  // emulation thread, tails to the render thread; both free running.
+  Render_Job_t jobs[RENDER_JOBS];
+  uint32_t job_head, job_tail;
+  uint32_t journal[RENDER_JOURNAL]; // VRAM address << 8 | byte
+  uint32_t journal_head, journal_tail;
+  bool sleeping, waiting;
+
+  // emulation thread only
+  uint32_t sent_oam_version, sent_palette_version;
+};
 
-    bg_tile_attrs[x] = tile_attr;
-    bg_color_ids[x] = color_id;
+static inline uint32_t ring_load(uint32_t *p) {
+  return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
 
-    uint32_t color;
-    if (d->bus->is_cgb) {
-      uint8_t palette_num = tile_attr & 0x07;
-      color = cgb_2_rgb(d->bg_pallete, palette_num, color_id);
-    } else {
-      color = d->pallete[(d->BGP >> (color_id * 2)) & 3];
-    }
-    d->framebuffer[d->LY * GB_WIDTH + x] = 0xFF000000 | color;
+// Emulation thread: blocks until at most max entries are left between
+// *tail and head
+static void render_wait(Ppu_Render_t *r, uint32_t *tail, uint32_t head, uint32_t max) {
+  if (head - ring_load(tail) <= max) return;
+  pthread_mutex_lock(&r->lock);
+  __atomic_store_n(&r->waiting, true, __ATOMIC_SEQ_CST);
+  while (head - ring_load(tail) > max)
+    pthread_cond_wait(&r->room, &r->lock);
+  __atomic_store_n(&r->waiting, false, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&r->lock);
+}
+
+static Render_Job_t *job_begin(Ppu_Render_t *r, int kind) {
+  render_wait(r, &r->job_tail, r->job_head, RENDER_JOBS - 1);
+  Render_Job_t *job = &r->jobs[r->job_head % RENDER_JOBS];
+  job->kind = (uint8_t)kind;
+  job->journal_end = r->journal_head;
+  return job;
+}
+
+static void job_commit(Ppu_Render_t *r) {
+  __atomic_store_n(&r->job_head, r->job_head + 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&r->sleeping, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&r->lock);
+    pthread_cond_signal(&r->wake);
+    pthread_mutex_unlock(&r->lock);
   }
 }
 
-static void render_sprites_scanline(Ppu_t *d) {
-  if (!(d->LCDC & 0x02))
-    return;
+static void render_journal(Ppu_Render_t *r, uint16_t addr, uint8_t byte) {
+  if (r->journal_head - ring_load(&r->journal_tail) >= RENDER_JOURNAL) {
+    // full while nothing is being drawn (LCD off, skipped frames): have
+    // the render thread catch up on what is there
+    job_begin(r, JOB_SYNC);
+    job_commit(r);
+    render_wait(r, &r->journal_tail, r->journal_head, RENDER_JOURNAL - 1);
+  }
+  r->journal[r->journal_head % RENDER_JOURNAL] = (uint32_t)addr << 8 | byte;
+  r->journal_head++;
+}
 
-  int sprite_height = (d->LCDC & 0x04) ? 16 : 8;
-  int sprites_drawn = 0;
-  
-  static int pixels_drawn = 0;
-  static int pixels_skipped_priority = 0;
-  static int pixels_skipped_bg = 0;
-  
-  for (int i = 39; i >= 0; i--) {
-    int oam_addr = i * 4;
-    uint8_t oam_y = d->bus->oam[oam_addr];
-    uint8_t oam_x = d->bus->oam[oam_addr + 1];
-    uint8_t tile_num = d->bus->oam[oam_addr + 2];
-    uint8_t attributes = d->bus->oam[oam_addr + 3];
-
-    if (oam_y == 0 || oam_y >= 160) continue;
-    
-    int sprite_y = oam_y - 16;
-    int sprite_x = oam_x - 8;
+static void render_queue_line(Ppu_t *d) {
+  Ppu_Render_t *r = d->render;
+  Render_Job_t *job = job_begin(r, JOB_LINE);
+
+  job->LY = d->LY;
+  job->LCDC = d->LCDC;
+  job->SCY = d->SCY;
+  job->SCX = d->SCX;
+  job->WY = d->WY;
+  job->WX = d->WX;
+  job->BGP = d->BGP;
+  job->OBP0 = d->OBP0;
+  job->OBP1 = d->OBP1;
+  job->has_oam = r->sent_oam_version != d->oam_version;
+  if (job->has_oam) {
+    memcpy(job->oam, d->bus->oam, OAM_SIZE);
+    job->oam_version = r->sent_oam_version = d->oam_version;
+  }
+  job->has_colors = r->sent_palette_version != d->palette_version;
+  if (job->has_colors) {
+    memcpy(job->colors, d->colors, sizeof(job->colors));
+    job->palette_version = r->sent_palette_version = d->palette_version;
+  }
+  job_commit(r);
+}
 
-    int sprite_top = sprite_y;
-    int sprite_bottom = sprite_y + sprite_height;
-    
-    if (d->LY < sprite_top || d->LY >= sprite_bottom)
-      continue;
+static void render_run_job(Ppu_Render_t *r, const Render_Job_t *job) {
+  Ppu_t *d = &r->ppu;
 
-    if (sprites_drawn >= 10)
-      continue;
-    
-    
-    sprites_drawn++;
+  uint32_t tail = r->journal_tail;
+  for (; tail != job->journal_end; tail++) {
+    uint32_t entry = r->journal[tail % RENDER_JOURNAL];
+    uint16_t addr = (uint16_t)(entry >> 8);
+    r->bus.vram[addr] = (uint8_t)entry;
+    vram_changed(d, addr);
+  }
+  __atomic_store_n(&r->journal_tail, tail, __ATOMIC_SEQ_CST);
+
+  switch (job->kind) {
+    case JOB_LINE:
+      d->LY = job->LY;
+      d->LCDC = job->LCDC;
+      d->SCY = job->SCY;
+      d->SCX = job->SCX;
+      d->WY = job->WY;
+      d->WX = job->WX;
+      d->BGP = job->BGP;
+      d->OBP0 = job->OBP0;
+      d->OBP1 = job->OBP1;
+      if (job->has_oam) {
+        memcpy(r->bus.oam, job->oam, OAM_SIZE);
+        d->oam_version = job->oam_version;
+      }
+      if (job->has_colors) {
+        memcpy(d->colors, job->colors, sizeof(d->colors));
+        d->palette_version = job->palette_version;
+      }
+      render_scanline(d);
+      break;
+    case JOB_FRAME_END:
+      publish_frame(d);
+      // read by next_line on the emulation thread
+      __atomic_store_n(&d->frame_lines_rendered, d->lines_rendered, __ATOMIC_RELAXED);
+      __atomic_store_n(&d->frame_lines_reused, d->lines_reused, __ATOMIC_RELAXED);
+      d->lines_rendered = d->lines_reused = 0;
+      break;
+    default:
+      break;
+  }
+}
 
-    int palette = (attributes & 0x10) ? d->OBP1 : d->OBP0;
-    int flip_x = attributes & 0x20;
-    int flip_y = attributes & 0x40;
-    int priority = attributes & 0x80;
-    
-    uint8_t sprite_palette = 0;
-    if (d->bus->is_cgb) {
-      sprite_palette = attributes & 0x07;
+static void *render_thread_main(void *arg) {
+  Ppu_Render_t *r = (Ppu_Render_t*)arg;
+
+  for (;;) {
+    uint32_t tail = r->job_tail;
+    if (tail == ring_load(&r->job_head)) {
+      pthread_mutex_lock(&r->lock);
+      __atomic_store_n(&r->sleeping, true, __ATOMIC_SEQ_CST);
+      while (tail == ring_load(&r->job_head))
+        pthread_cond_wait(&r->wake, &r->lock);
+      __atomic_store_n(&r->sleeping, false, __ATOMIC_SEQ_CST);
+      pthread_mutex_unlock(&r->lock);
     }
 
-    int line = d->LY - sprite_y;
-    
-    if (line < 0 || line >= sprite_height) {
-      continue;
+    const Render_Job_t *job = &r->jobs[tail % RENDER_JOBS];
+    bool stop = job->kind == JOB_STOP;
+    render_run_job(r, job);
+    __atomic_store_n(&r->job_tail, tail + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST)) {
+      pthread_mutex_lock(&r->lock);
+      pthread_cond_signal(&r->room);
+      pthread_mutex_unlock(&r->lock);
     }
-    
-    if (flip_y)
-      line = sprite_height - 1 - line;
+    if (stop) return NULL;
+  }
+}
 
-    if (sprite_height == 16) {
-      tile_num &= 0xFE; 
-      if (line >= 8) {
-        tile_num |= 0x01;
-        line -= 8;
-      }
-    }
+int ppu_start_render_thread(Ppu_t *d) {
+  if (d->render) return 0;
+  if (d->accurate) {
+    fprintf(stderr, "[PPU] the render thread needs the line renderer, not --accurate\n");
+    return -1;
+  }
 
-    uint16_t tile_addr = 0x8000 + (tile_num * 16);
-    
-    uint8_t low, high;
-    if (d->bus->is_cgb && (attributes & 0x08)) {
-      low = read_vram_bank(d->bus, tile_addr + (line * 2), 1);
-      high = read_vram_bank(d->bus, tile_addr + (line * 2) + 1, 1);
+  Ppu_Render_t *r = (Ppu_Render_t*)calloc(1, sizeof(Ppu_Render_t));
+  Tile_Cache_t *tiles = (Tile_Cache_t*)calloc(1, sizeof(Tile_Cache_t));
+  if (!r || !tiles) {
+    fprintf(stderr, "[PPU] out of memory for the render thread\n");
+    free(r);
+    free(tiles);
+    return -1;
+  }
+
+  // the render side starts from the current frames, signatures and VRAM
+  r->ppu = *d;
+  r->ppu.bus = &r->bus;
+  r->ppu.tiles = tiles;
+  r->bus.is_cgb = d->bus->is_cgb;
+  memcpy(r->bus.vram, d->bus->vram, sizeof(r->bus.vram));
+  memcpy(r->bus.oam, d->bus->oam, sizeof(r->bus.oam));
+  r->sent_oam_version = d->oam_version;
+  r->sent_palette_version = d->palette_version;
+
+  pthread_mutex_init(&r->lock, NULL);
+  pthread_cond_init(&r->wake, NULL);
+  pthread_cond_init(&r->room, NULL);
+  if (pthread_create(&r->thread, NULL, render_thread_main, r) != 0) {
+    fprintf(stderr, "[PPU] can't start the render thread\n");
+    pthread_cond_destroy(&r->room);
+    pthread_cond_destroy(&r->wake);
+    pthread_mutex_destroy(&r->lock);
+    free(tiles);
+    free(r);
+    return -1;
+  }
+  d->render = r;
+  return 0;
+}
+
+void ppu_render_flush(Ppu_t *d) {
+  Ppu_Render_t *r = d->render;
+  if (r) render_wait(r, &r->job_tail, r->job_head, 0);
+}
+
+void ppu_stop_render_thread(Ppu_t *d) {
+  Ppu_Render_t *r = d->render;
+  if (!r) return;
+
+  job_begin(r, JOB_STOP);
+  job_commit(r);
+  pthread_join(r->thread, NULL);
+
+  // take the frames back. Signatures were built from the render side's
+  // version counters, so every row is drawn again.
+  d->frame_back = r->ppu.frame_back;
+  d->frame_front = r->ppu.frame_front;
+  d->frame_shared = r->ppu.frame_shared;
+  d->output = r->ppu.output;
+  d->framebuffer = r->ppu.framebuffer;
+  d->gray_lines = r->ppu.gray_lines;
+  d->small_dirty = r->ppu.small_dirty;
+  d->frame_lines_rendered = r->ppu.frame_lines_rendered;
+  d->frame_lines_reused = r->ppu.frame_lines_reused;
+  memset(d->line_sig, 0, sizeof(d->line_sig));
+
+  pthread_cond_destroy(&r->room);
+  pthread_cond_destroy(&r->wake);
+  pthread_mutex_destroy(&r->lock);
+  free(r->ppu.tiles);
+  free(r);
+  d->render = NULL;
+}
+
+const void *ppu_acquire_frame(Ppu_t *d, bool *fresh) {
+  if (d->render) d = &d->render->ppu;
+  bool is_new = (__atomic_load_n(&d->frame_shared, __ATOMIC_ACQUIRE) & PPU_FRAME_FRESH) != 0;
+  if (is_new) {
+    uint8_t old = __atomic_exchange_n(&d->frame_shared, d->frame_front, __ATOMIC_ACQ_REL);
+    d->frame_front = old & ~PPU_FRAME_FRESH;
+  }
+  if (fresh) *fresh = is_new;
+  return d->frames[d->frame_front];
+}
+
+// STAT interrupt line: the enabled sources ORed together. Only a rising
+// edge requests the interrupt, so a source becoming true while another
+// one already holds the line high is not seen.
+static void stat_update(Ppu_t *d, Bus_t *b) {
+  uint8_t stat = d->STAT;
+  int mode = stat & 0x03;
+  bool line = (d->LCDC & LCDC_ENABLE) &&
+              (((stat & 0x40) && (stat & 0x04)) ||
+               ((stat & 0x08) && mode == 0) ||
+               ((stat & 0x10) && mode == 1) ||
+               ((stat & 0x20) && mode == 2));
+  if (line && !d->stat_line)
+    b->IF |= 0x02;
+  d->stat_line = line;
+}
+
+static inline void update_coincidence(Ppu_t *d) {
+  if (d->LY == d->LYC)
+    d->STAT |= 0x04;
+  else
+    d->STAT &= ~0x04;
+}
+
+// LY advance at the end of a line, shared by both backends
+static void next_line(Ppu_t *d, Bus_t *b) {
+  d->LY++;
+
+  if (d->LY > 153) {
+    d->LY = 0;
+  }
+
+  if (d->LY == 144) {
+    d->STAT = (d->STAT & ~0x03) | 1; // mode 1 = VBlank
+    b->IF |= 0x01;                   // request VBlank interrupt
+    d->frame_ready = true;
+    if (d->render && !d->skip_frame) {
+      job_begin(d->render, JOB_FRAME_END);
+      job_commit(d->render);
+    } else if (!d->skip_frame) {
+      publish_frame(d);
+    }
+    if (d->render) {
+      // counted on the render side, which may be a frame behind
+      d->frame_lines_rendered = __atomic_load_n(&d->render->ppu.frame_lines_rendered, __ATOMIC_RELAXED);
+      d->frame_lines_reused = __atomic_load_n(&d->render->ppu.frame_lines_reused, __ATOMIC_RELAXED);
     } else {
-      low = read_vram_bank(d->bus, tile_addr + (line * 2), 0);
-      high = read_vram_bank(d->bus, tile_addr + (line * 2) + 1, 0);
+      d->frame_lines_rendered = d->lines_rendered;
+      d->frame_lines_reused = d->lines_reused;
+      d->lines_rendered = d->lines_reused = 0;
     }
 
-    for (int px = 0; px < 8; px++) {
-      int screen_x = sprite_x + px;
+    // decide whether the next frame gets drawn
+    d->frame_count++;
+    d->skip_frame = !d->render_every || (d->frame_count % d->render_every) != 0;
 
-      if (screen_x < 0 || screen_x >= GB_WIDTH)
-        continue;
+    if (b->cheats)
+      cheat_apply_frame(b);
+    if (b->cartridge && b->cartridge->save)
+      save_frame(b->cartridge);
+  } else if (d->LY < 144) {
+    d->STAT = (d->STAT & ~0x03) | 2;
+  }
 
-      int bit = flip_x ? px : (7 - px);
-      int color_id = ((high >> bit) & 1) << 1 | ((low >> bit) & 1);
+  update_coincidence(d);
+  stat_update(d, b);
+}
 
-      if (color_id == 0)
-        continue;
+static void enter_hblank(Ppu_t *d, Bus_t *b) {
+  // CGB HBlank HDMA transfer
+  if ((d->STAT & 0x03) != 0 && d->hdma_active)
+    hdma_transfer1(d, b);
+  d->STAT = (d->STAT & ~0x03) | 0;
+  stat_update(d, b);
+}
 
-      int fb_index = d->LY * GB_WIDTH + screen_x;
-      
-      if (d->bus->is_cgb) {
-        uint8_t bg_tile_attr = bg_tile_attrs[screen_x];
-        uint8_t bg_color_id = bg_color_ids[screen_x];
-        
-        bool bg_priority = (bg_tile_attr & 0x80) != 0;
-        bool lcdc_bg_enable = (d->LCDC & 0x01) != 0;
-        
-        if (lcdc_bg_enable && bg_priority && bg_color_id != 0) {
-          if (d->LY == 80) pixels_skipped_bg++;
-          continue;
-        }
-        
-        if (lcdc_bg_enable && priority && bg_color_id != 0) {
-          if (d->LY == 80) pixels_skipped_priority++;
-          continue;
-        }
-        
-        if (d->LY == 80) pixels_drawn++;
-        
-        uint32_t color = cgb_2_rgb(d->obj_pallete, sprite_palette, color_id);
-        d->framebuffer[fb_index] = 0xFF000000 | color;
-      } else {
-        if (priority) {
-          uint32_t bg_pixel = d->framebuffer[fb_index];
-          uint32_t bg_color = bg_pixel & 0x00FFFFFF;
-          uint32_t bg_color0 = d->pallete[0] & 0x00FFFFFF;
-          if (bg_color != bg_color0) {
-            continue;
-          }
-        }
-        int shade = (palette >> (color_id * 2)) & 0x03;
-        uint32_t color = d->pallete[shade];
-        d->framebuffer[fb_index] = 0xFF000000 | color;
+// Fast path mode changes, due when cycles_in_line reaches next_event:
+// 2 -> 3 at 80, 3 -> 0 at 252, next line at 456
+static void line_event(Ppu_t *d, Bus_t *b) {
+  switch (d->STAT & 0x03) {
+    case 2:
+      d->STAT = (d->STAT & ~0x03) | 3;
+      stat_update(d, b);
+      d->next_event = 252;
+      break;
+    case 3:
+      enter_hblank(d, b);
+      d->next_event = 456;
+      break;
+    default: // HBlank or VBlank
+      d->cycles_in_line -= 456;
+      next_line(d, b);
+      d->next_event = d->LY < 144 ? 80 : 456;
+
+      // render the newly-started scanline.
+      if (d->LY < 144 && !d->skip_frame) {
+        if (d->render)
+          render_queue_line(d);
+        else
+          render_scanline(d);
       }
+      break;
+  }
+}
+
+static void display_cycle_fifo(Ppu_t *d, Bus_t *b, int cycles) {
+  for (int i = 0; i < cycles; i++) {
+    if (++d->cycles_in_line >= 456) {
+      d->cycles_in_line -= 456;
+      d->fifo.drawing = false;
+      next_line(d, b);
+    }
+    if (d->LY >= 144) continue;
+
+    if (d->cycles_in_line == 80) {
+      // mode 3 length now depends on SCX, the window and sprites
+      d->STAT = (d->STAT & ~0x03) | 3;
+      stat_update(d, b);
+      fifo_start_line(d);
+    } else if (d->fifo.drawing && fifo_dot(d)) {
+      d->fifo.drawing = false;
+      if (d->fifo.in_window) d->fifo.win_line++;
+      if (d->format != PPU_FORMAT_ARGB8888 && !d->skip_frame) {
+        emit_line(d, d->line_slots);
+        if (d->format == PPU_FORMAT_GRAY_SMALL) finish_small_row(d);
+      }
+      enter_hblank(d, b);
     }
   }
 }
@@ -418,8 +1249,6 @@ void display_cycle(Ppu_t *d, Bus_t *b, int cycles) {
   // fprintf(stderr, "[LCDC=%02X SCX=%02X SCY=%02X]\n", d->LCDC, d->SCX,
   // d->SCY);
 
-  d->cycles_in_line += cycles;
-
   if (d->dma_pending) {
     d->dma_pending = false;
     d->dma_active = true;
@@ -455,6 +1284,8 @@ void display_cycle(Ppu_t *d, Bus_t *b, int cycles) {
       }
       
       b->oam[d->dma_counter] = byte;
+      DIRTY_MARK(b->dirty.oam, 0);
+      d->oam_version++;
       d->dma_counter++;
     }
     
@@ -467,70 +1298,47 @@ void display_cycle(Ppu_t *d, Bus_t *b, int cycles) {
     dma_cycle_counter = 0;
   }
 
-  if (d->cycles_in_line >= 456) {
-    d->cycles_in_line -= 456;
-
-    d->LY++;
-
-    if (d->LY > 153) {
-      d->LY = 0;
-    }
-
-    if (d->LY == 144) {
-      d->STAT = (d->STAT & ~0x03) | 1; // mode 1 = VBlank
-      b->IF |= 0x01;                   // request VBlank interrupt
-
-      if (d->STAT & 0x10) // STAT bit 4 = VBlank interrupt enable
-        b->IF |= 0x02;
-      d->frame_ready = true;
-    } else if (d->LY < 144) {
-      d->STAT = (d->STAT & ~0x03) | 2;
-      if (d->STAT & 0x20)
-        b->IF |= 0x02;
-    }
+  if (d->accurate) {
+    display_cycle_fifo(d, b, cycles);
+    return;
+  }
 
-    if (d->LY == d->LYC) {
-      d->STAT |= 0x04;
-      if (d->STAT & 0x40)
-        b->IF |= 0x02;
-    } else {
-      d->STAT &= ~0x04;
-    }
+  d->cycles_in_line += cycles;
+  while (d->cycles_in_line >= d->next_event)
+    line_event(d, b);
+}
 
-    // render the newly-started scanline.
-    if (d->LY < 144) {
-      uint32_t bg_color = d->pallete[0];
-      for (int x = 0; x < GB_WIDTH; x++) {
-        d->framebuffer[d->LY * GB_WIDTH + x] = 0xFF000000 | bg_color;
-        bg_tile_attrs[x] = 0;
-        bg_color_ids[x] = 0;
-      }
-      render_bg_scanline(d);
-      render_window_scanline(d);
-      render_sprites_scanline(d);
-    }
+void ppu_write_lcdc(Ppu_t *d, uint8_t val) {
+  bool was_enabled = (d->LCDC & LCDC_ENABLE) != 0;
+  bool is_enabled = (val & LCDC_ENABLE) != 0;
+  d->LCDC = val;
+
+  if (!was_enabled && is_enabled) {
+    d->LY = 0;
+    d->cycles_in_line = 0;
+    d->STAT = (d->STAT & ~0x03) | 2; // Start in mode 2 (OAM scan)
+    d->next_event = 80;
+    d->fifo.drawing = false; // --accurate: don't resume a line cut off in mode 3
+    update_coincidence(d);
+  } else if (was_enabled && !is_enabled) {
+    d->LY = 0;
+    d->cycles_in_line = 0;
+    d->STAT = (d->STAT & ~0x03) | 0;
+    d->fifo.drawing = false;
   }
+  stat_update(d, d->bus);
+}
 
-  if (d->LY < 144) {
-    if (d->cycles_in_line < 80) {
-      // mode 2: OAM scan
-      d->STAT = (d->STAT & ~0x03) | 2;
-    } else if (d->cycles_in_line < 252) {
-      // mode 3: drawing (OAM+VRAM)
-      d->STAT = (d->STAT & ~0x03) | 3;
-    } else {
-      // mode 0: HBlank
-      if ((d->STAT & 0x03) != 0) {
-        // CGB HBlank HDMA transfer
-        if (d->hdma_active) {
-          hdma_transfer1(d, b);
-        }
-        if (d->STAT & 0x08) 
-          b->IF |= 0x02;
-      }
-      d->STAT = (d->STAT & ~0x03) | 0;
-    }
-  }
+void ppu_write_stat(Ppu_t *d, uint8_t val) {
+  d->STAT = (val & 0x78) | (d->STAT & 0x07);
+  stat_update(d, d->bus);
+}
+
+void ppu_write_lyc(Ppu_t *d, uint8_t val) {
+  d->LYC = val;
+  if (d->LCDC & LCDC_ENABLE)
+    update_coincidence(d);
+  stat_update(d, d->bus);
 }
 
 bool ppu_is_mode2(Ppu_t *ppu) {
@@ -555,5 +1363,27 @@ void ppu_vram_write(Ppu_t *ppu, uint16_t addr, uint8_t byte) {
   if (addr >= 0x4000u)
     return;
   ppu->bus->vram[addr] = byte;
+  vram_changed(ppu, addr);
+  if (ppu->render) render_journal(ppu->render, addr, byte);
+  DIRTY_MARK(ppu->bus->dirty.vram, addr);
 }
 
+void ppu_vram_write_block(Ppu_t *ppu, uint16_t addr, const uint8_t *src, uint16_t len) {
+  if (!ppu || !ppu->bus)
+    return;
+  if (addr >= 0x4000u)
+    return;
+  if (len > 0x4000u - addr)
+    len = (uint16_t)(0x4000u - addr);
+  memmove(&ppu->bus->vram[addr], src, len);
+  for (uint32_t a = addr & ~0xFu; a < (uint32_t)addr + len; a += 16)
+    vram_changed(ppu, (uint16_t)a);
+  if (ppu->render) {
+    for (uint16_t i = 0; i < len; i++)
+      render_journal(ppu->render, (uint16_t)(addr + i), ppu->bus->vram[addr + i]);
+  }
+#ifdef DIRTY_PAGES
+  for (uint32_t page = addr >> DIRTY_PAGE_SHIFT; page <= (uint32_t)(addr + len - 1) >> DIRTY_PAGE_SHIFT; page++)
+    DIRTY_MARK(ppu->bus->dirty.vram, page << DIRTY_PAGE_SHIFT);
+#endif
+}
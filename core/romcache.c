@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "romcache.h"
+#include "unpack.h"
+
+static Rom_Image_t *rom_cache = NULL;
+static pthread_mutex_t rom_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint64_t rom_hash(const uint8_t *data, size_t len) {
+  const uint64_t k = 0x9E3779B97F4A7C15ull;
+  uint64_t h = 0xCBF29CE484222325ull ^ (uint64_t)len;
+  size_t i = 0;
+
+  for (; i + 8 <= len; i += 8) {
+    uint64_t w;
+    memcpy(&w, data + i, 8);
+    h = (h ^ w) * k;
+    h ^= h >> 29;
+  }
+  for (; i < len; i++) {
+    h = (h ^ data[i]) * 0x100000001B3ull;
+  }
+  h ^= h >> 32;
+  return h * k;
+}
+
+static int64_t file_mtime(const struct stat *st) {
+  return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+static Rom_Image_t *find_file(const struct stat *st) {
+  for (Rom_Image_t *img = rom_cache; img; img = img->next) {
+    if (img->ino == (uint64_t)st->st_ino && img->dev == (uint64_t)st->st_dev &&
+        img->mtime == file_mtime(st) && img->file_size == (size_t)st->st_size)
+      return img;
+  }
+  return NULL;
+}
+
+static Rom_Image_t *find_hash(uint64_t hash, size_t size) {
+  for (Rom_Image_t *img = rom_cache; img; img = img->next) {
+    if (img->hash == hash && img->size == size)
+      return img;
+  }
+  return NULL;
+}
+
+// Maps the file when it is a whole number of banks; anything else is read
+// into a buffer padded with 0xFF, since mapped pages past EOF would fault.
+static uint8_t *map_file(int fd, size_t size, size_t *padded, bool *mapped) {
+  *padded = (size + 0x3FFFu) & ~(size_t)0x3FFFu;
+
+  if (*padded == size) {
+    void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      *mapped = true;
+      return (uint8_t*)p;
+    }
+  }
+
+  uint8_t *buf = (uint8_t*)malloc(*padded);
+  if (!buf) return NULL;
+  size_t got = 0;
+  while (got < size) {
+    ssize_t n = read(fd, buf + got, size - got);
+    if (n <= 0) {
+      free(buf);
+      return NULL;
+    }
+    got += (size_t)n;
+  }
+  memset(buf + size, 0xFF, *padded - size);
+  *mapped = false;
+  return buf;
+}
+
+// gzip/zip: the container is mapped and inflated straight into the ROM
+// buffer, which is never backed by the file
+static uint8_t *unpack_file(int fd, size_t file_size, size_t *size, size_t *padded) {
+  uint8_t *src = (uint8_t*)mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (src == MAP_FAILED) return NULL;
+  uint8_t *data = unpack_rom(src, file_size, size, padded);
+  munmap(src, file_size);
+  return data;
+}
+
+static bool is_compressed(int fd) {
+  uint8_t magic[4];
+  return pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic) &&
+         unpack_is_compressed(magic, sizeof(magic));
+}
+
+static void unmap_image(Rom_Image_t *img) {
+  if (img->mapped) munmap(img->data, img->padded);
+  else free(img->data);
+}
+
+Rom_Image_t *rom_cache_acquire(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) { perror("Open ROM"); return NULL; }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return NULL;
+  }
+
+  pthread_mutex_lock(&rom_cache_lock);
+  Rom_Image_t *img = find_file(&st);
+  if (img) {
+    img->refs++;
+    pthread_mutex_unlock(&rom_cache_lock);
+    close(fd);
+    return img;
+  }
+  pthread_mutex_unlock(&rom_cache_lock);
+
+  size_t size = (size_t)st.st_size;
+  size_t padded;
+  bool mapped = false;
+  uint8_t *data = is_compressed(fd)
+    ? unpack_file(fd, (size_t)st.st_size, &size, &padded)
+    : map_file(fd, size, &padded, &mapped);
+  close(fd);
+  if (!data) {
+    fprintf(stderr, "[ROM] failed to load %s\n", path);
+    return NULL;
+  }
+  uint64_t hash = rom_hash(data, size);
+
+  pthread_mutex_lock(&rom_cache_lock);
+  img = find_hash(hash, size);
+  if (img && memcmp(img->data, data, size) == 0) {
+    img->refs++;
+    pthread_mutex_unlock(&rom_cache_lock);
+    if (mapped) munmap(data, padded);
+    else free(data);
+    return img;
+  }
+
+  img = (Rom_Image_t*)calloc(1, sizeof(Rom_Image_t));
+  if (!img) {
+    pthread_mutex_unlock(&rom_cache_lock);
+    if (mapped) munmap(data, padded);
+    else free(data);
+    return NULL;
+  }
+  img->data = data;
+  img->size = size;
+  img->padded = padded;
+  img->hash = hash;
+  img->mapped = mapped;
+  img->refs = 1;
+  img->dev = (uint64_t)st.st_dev;
+  img->ino = (uint64_t)st.st_ino;
+  img->file_size = (size_t)st.st_size;
+  img->mtime = file_mtime(&st);
+  img->next = rom_cache;
+  rom_cache = img;
+  pthread_mutex_unlock(&rom_cache_lock);
+  return img;
+}
+
+void rom_cache_release(Rom_Image_t *img) {
+  if (!img) return;
+
+  pthread_mutex_lock(&rom_cache_lock);
+  if (--img->refs > 0) {
+    pthread_mutex_unlock(&rom_cache_lock);
+    return;
+  }
+  for (Rom_Image_t **link = &rom_cache; *link; link = &(*link)->next) {
+    if (*link == img) {
+      *link = img->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&rom_cache_lock);
+
+  unmap_image(img);
+  free(img);
+}
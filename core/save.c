@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // flock
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "save.h"
+
+static Save_File_t *saves = NULL;
+static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t save_cond = PTHREAD_COND_INITIALIZER;
+static bool flusher_running = false;
+static pthread_t flusher;
+
+static void sav_path(const char *rom_path, char *out, size_t len) {
+  snprintf(out, len, "%s", rom_path);
+  char *dot = strrchr(out, '.');
+  char *slash = strrchr(out, '/');
+  if (dot && (!slash || dot > slash)) *dot = '\0';
+  strncat(out, ".sav", len - strlen(out) - 1);
+}
+
+// msync each run of dirty pages. Bits are taken atomically so pages the
+// emulation thread dirties meanwhile are picked up next time.
+static void save_flush(Save_File_t *save, int flags) {
+  uint64_t dirty = __atomic_exchange_n(&save->dirty, 0, __ATOMIC_ACQ_REL);
+  while (dirty) {
+    int first = __builtin_ctzll(dirty);
+    int last = first;
+    while (last < 63 && ((dirty >> (last + 1)) & 1)) last++;
+    for (int i = first; i <= last; i++) dirty &= ~(1ull << i);
+
+    size_t off = (size_t)first << SAVE_PAGE_SHIFT;
+    size_t end = ((size_t)last + 1) << SAVE_PAGE_SHIFT;
+    if (end > save->map_size) end = save->map_size;
+    if (off < end && msync(save->map + off, end - off, flags) != 0)
+      perror("[SAVE] msync");
+  }
+}
+
+static void *flusher_main(void *arg) {
+  (void)arg;
+  pthread_mutex_lock(&save_lock);
+  for (;;) {
+    // the emulation thread signals without the lock, so look for
+    // requests before sleeping; a missed wakeup waits for the timer
+    bool requested = false;
+    for (Save_File_t *s = saves; s; s = s->next) {
+      if (__atomic_load_n(&s->flush_requested, __ATOMIC_RELAXED)) requested = true;
+    }
+    if (!requested) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += SAVE_FLUSH_INTERVAL;
+      pthread_cond_timedwait(&save_cond, &save_lock, &deadline);
+    }
+
+    for (Save_File_t *s = saves; s; s = s->next) {
+      __atomic_store_n(&s->flush_requested, 0, __ATOMIC_RELAXED);
+      save_flush(s, MS_ASYNC);
+    }
+  }
+  return NULL;
+}
+
+// Another session holds the .sav: start from its contents in the heap
+// buffer load_cart allocated, without writing anything back
+static void save_read_private(Cartridge_t *cart, int fd) {
+  bool has_rtc = (cart->type == MBC_3);
+  struct stat st;
+  if (fstat(fd, &st) != 0) return;
+
+  if (cart->ram && pread(fd, cart->ram, cart->ram_size, 0) < 0)
+    perror("[SAVE] read");
+  uint8_t rtc[SAVE_RTC_SIZE];
+  if (has_rtc && (size_t)st.st_size >= cart->ram_size + SAVE_RTC_SIZE &&
+      pread(fd, rtc, SAVE_RTC_SIZE, (off_t)cart->ram_size) == SAVE_RTC_SIZE)
+    cart_rtc_load(cart, rtc);
+}
+
+int save_open(Cartridge_t *cart, const char *rom_path) {
+  bool has_rtc = (cart->type == MBC_3);
+  size_t ram_size = cart->ram_size;
+  size_t map_size = ram_size + (has_rtc ? SAVE_RTC_SIZE : 0);
+  // nothing to persist, don't leave an empty .sav behind
+  if (map_size == 0) return -1;
+
+  char path[1024];
+  sav_path(rom_path, path, sizeof(path));
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    perror("[SAVE] open");
+    return -1;
+  }
+  // sessions running the same ROM would share the mapped pages; only
+  // the first one gets to map it
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    fprintf(stderr, "[SAVE] %s is in use by another session, progress won't be saved\n", path);
+    save_read_private(cart, fd);
+    close(fd);
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  bool had_rtc = has_rtc && (size_t)st.st_size >= map_size;
+  if ((size_t)st.st_size < map_size && ftruncate(fd, (off_t)map_size) != 0) {
+    perror("[SAVE] ftruncate");
+    close(fd);
+    return -1;
+  }
+
+  void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    perror("[SAVE] mmap");
+    close(fd);
+    return -1;
+  }
+
+  Save_File_t *save = (Save_File_t*)calloc(1, sizeof(Save_File_t));
+  if (!save) {
+    munmap(map, map_size);
+    close(fd);
+    return -1;
+  }
+  save->fd = fd;
+  save->map = (uint8_t*)map;
+  save->map_size = map_size;
+  save->ram_size = ram_size;
+  save->has_rtc = has_rtc;
+
+  free(cart->ram);
+  cart->ram = ram_size ? save->map : NULL;
+  cart->save = save;
+  if (had_rtc) cart_rtc_load(cart, save->map + ram_size);
+
+  pthread_mutex_lock(&save_lock);
+  save->next = saves;
+  saves = save;
+  if (!flusher_running && pthread_create(&flusher, NULL, flusher_main, NULL) == 0) {
+    pthread_detach(flusher);
+    flusher_running = true;
+  }
+  pthread_mutex_unlock(&save_lock);
+
+  fprintf(stderr, "[SAVE] %s (%zu bytes)\n", path, map_size);
+  return 0;
+}
+
+void save_request_flush(Cartridge_t *cart) {
+  Save_File_t *save = cart->save;
+  if (!save) return;
+
+  if (save->has_rtc) {
+    cart_rtc_store(cart, save->map + save->ram_size);
+    save_mark(save, save->ram_size);
+  }
+  if (__atomic_exchange_n(&save->flush_requested, 1, __ATOMIC_RELAXED) == 0)
+    pthread_cond_signal(&save_cond);
+}
+
+void save_frame(Cartridge_t *cart) {
+  Save_File_t *save = cart->save;
+  if (!save || !save->has_rtc) return;
+
+  // the footer only changes once a second, don't dirty the page for less
+  uint8_t footer[SAVE_RTC_SIZE];
+  uint8_t *out = save->map + save->ram_size;
+  cart_rtc_store(cart, footer);
+  if (memcmp(out, footer, SAVE_RTC_SIZE) != 0) {
+    memcpy(out, footer, SAVE_RTC_SIZE);
+    save_mark(save, save->ram_size);
+  }
+}
+
+void save_close(Cartridge_t *cart) {
+  Save_File_t *save = cart->save;
+  if (!save) return;
+
+  pthread_mutex_lock(&save_lock);
+  for (Save_File_t **link = &saves; *link; link = &(*link)->next) {
+    if (*link == save) {
+      *link = save->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&save_lock);
+
+  if (save->has_rtc) cart_rtc_store(cart, save->map + save->ram_size);
+  msync(save->map, save->map_size, MS_SYNC);
+  munmap(save->map, save->map_size);
+  close(save->fd);
+  free(save);
+
+  cart->save = NULL;
+  cart->ram = NULL;
+}
@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "search.h"
+#include "memory.h"
+#include "mbc.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+// SEARCH_NO_AVX2 lets tests/check_search.c build the SSE2 and scalar paths
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(SEARCH_NO_AVX2)
+#include <immintrin.h>
+#define SEARCH_HAVE_AVX2 1
+#endif
+
+typedef uint64_t (*match64_fn)(const uint8_t *cur, const uint8_t *prev,
+                               search_width_t width, search_op_t op, uint32_t operand);
+
+static uint8_t *region_ptr(Bus_t *bus, search_region_t region, size_t *size) {
+  switch (region) {
+    case SEARCH_WRAM:
+      *size = sizeof(bus->wram);
+      return bus->wram;
+    case SEARCH_HRAM:
+      *size = sizeof(bus->hram);
+      return bus->hram;
+    case SEARCH_CART_RAM:
+      if (!bus->cartridge || !bus->cartridge->ram) break;
+      *size = bus->cartridge->ram_size;
+      return bus->cartridge->ram;
+  }
+  *size = 0;
+  return NULL;
+}
+
+/* ---------------- scalar ---------------- */
+
+static bool read_value(const uint8_t *mem, size_t i, size_t size, search_width_t width, uint32_t *out) {
+  switch (width) {
+    case SEARCH_U16:
+      if (i + 1 >= size) return false;
+      *out = (uint32_t)mem[i] | ((uint32_t)mem[i + 1] << 8);
+      return true;
+    case SEARCH_BCD8:
+      if ((mem[i] & 0x0F) > 9 || (mem[i] >> 4) > 9) return false;
+      *out = (uint32_t)(mem[i] >> 4) * 10u + (mem[i] & 0x0F);
+      return true;
+    case SEARCH_U8:
+    default:
+      *out = mem[i];
+      return true;
+  }
+}
+
+static bool match_one(const uint8_t *cur, const uint8_t *prev, size_t i, size_t size,
+                      search_width_t width, search_op_t op, uint32_t operand) {
+  uint32_t mask = (width == SEARCH_U16) ? 0xFFFFu : 0xFFu;
+  uint32_t c, p;
+  if (!read_value(cur, i, size, width, &c)) return false;
+  if (op == SEARCH_EQ) return c == (operand & mask);
+  if (!read_value(prev, i, size, width, &p)) return false;
+
+  switch (op) {
+    case SEARCH_CHANGED:   return c != p;
+    case SEARCH_UNCHANGED: return c == p;
+    case SEARCH_INC:       return c > p;
+    case SEARCH_DEC:       return c < p;
+    case SEARCH_INC_BY:    return c == ((p + operand) & mask);
+    case SEARCH_DEC_BY:    return c == ((p - operand) & mask);
+    default:               return false;
+  }
+}
+
+#if !defined(__SSE2__)
+static uint64_t match64_scalar(const uint8_t *cur, const uint8_t *prev,
+                               search_width_t width, search_op_t op, uint32_t operand) {
+  uint64_t bits = 0;
+  for (size_t i = 0; i < 64; i++) {
+    // callers guarantee one readable byte past the chunk
+    if (match_one(cur, prev, i, 65, width, op, operand))
+      bits |= 1ull << i;
+  }
+  return bits;
+}
+#endif
+
+/* ---------------- SSE2 ---------------- */
+
+#if defined(__SSE2__)
+static inline __m128i sse2_op8(__m128i c, __m128i p, __m128i arg, search_op_t op) {
+  __m128i eq = _mm_cmpeq_epi8(c, p);
+  switch (op) {
+    case SEARCH_EQ:        return _mm_cmpeq_epi8(c, arg);
+    case SEARCH_CHANGED:   return _mm_xor_si128(eq, _mm_set1_epi8(-1));
+    case SEARCH_UNCHANGED: return eq;
+    case SEARCH_INC:       return _mm_andnot_si128(eq, _mm_cmpeq_epi8(_mm_max_epu8(c, p), c));
+    case SEARCH_DEC:       return _mm_andnot_si128(eq, _mm_cmpeq_epi8(_mm_min_epu8(c, p), c));
+    case SEARCH_INC_BY:    return _mm_cmpeq_epi8(c, _mm_add_epi8(p, arg));
+    case SEARCH_DEC_BY:    return _mm_cmpeq_epi8(c, _mm_sub_epi8(p, arg));
+    default:               return _mm_setzero_si128();
+  }
+}
+
+static inline __m128i sse2_op16(__m128i c, __m128i p, __m128i arg, search_op_t op) {
+  const __m128i sign = _mm_set1_epi16((short)0x8000);
+  __m128i eq = _mm_cmpeq_epi16(c, p);
+  switch (op) {
+    case SEARCH_EQ:        return _mm_cmpeq_epi16(c, arg);
+    case SEARCH_CHANGED:   return _mm_xor_si128(eq, _mm_set1_epi8(-1));
+    case SEARCH_UNCHANGED: return eq;
+    case SEARCH_INC:       return _mm_cmpgt_epi16(_mm_xor_si128(c, sign), _mm_xor_si128(p, sign));
+    case SEARCH_DEC:       return _mm_cmpgt_epi16(_mm_xor_si128(p, sign), _mm_xor_si128(c, sign));
+    case SEARCH_INC_BY:    return _mm_cmpeq_epi16(c, _mm_add_epi16(p, arg));
+    case SEARCH_DEC_BY:    return _mm_cmpeq_epi16(c, _mm_sub_epi16(p, arg));
+    default:               return _mm_setzero_si128();
+  }
+}
+
+// packed BCD -> binary (b - 6 * high nibble), plus a lane mask of valid digits
+static inline __m128i sse2_bcd(__m128i b, __m128i *valid) {
+  const __m128i nib = _mm_set1_epi8(0x0F);
+  const __m128i nine = _mm_set1_epi8(9);
+  __m128i lo = _mm_and_si128(b, nib);
+  __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), nib);
+  *valid = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(lo, nine), lo),
+                         _mm_cmpeq_epi8(_mm_min_epu8(hi, nine), hi));
+  __m128i hi2 = _mm_add_epi8(hi, hi);
+  __m128i hi6 = _mm_add_epi8(_mm_add_epi8(hi2, hi2), hi2);
+  return _mm_sub_epi8(b, hi6);
+}
+
+static inline uint32_t sse2_mask16(const uint8_t *cur, const uint8_t *prev,
+                                   search_width_t width, search_op_t op, uint32_t operand) {
+  __m128i c = _mm_loadu_si128((const __m128i*)cur);
+  __m128i p = _mm_loadu_si128((const __m128i*)prev);
+
+  if (width == SEARCH_U16) {
+    __m128i arg = _mm_set1_epi16((short)operand);
+    __m128i c1 = _mm_loadu_si128((const __m128i*)(cur + 1));
+    __m128i p1 = _mm_loadu_si128((const __m128i*)(prev + 1));
+    uint32_t even = (uint32_t)_mm_movemask_epi8(sse2_op16(c, p, arg, op)) & 0x5555u;
+    uint32_t odd = (uint32_t)_mm_movemask_epi8(sse2_op16(c1, p1, arg, op)) & 0x5555u;
+    return even | (odd << 1);
+  }
+
+  __m128i arg = _mm_set1_epi8((char)operand);
+  if (width == SEARCH_BCD8) {
+    __m128i cv, pv;
+    c = sse2_bcd(c, &cv);
+    p = sse2_bcd(p, &pv);
+    __m128i valid = (op == SEARCH_EQ) ? cv : _mm_and_si128(cv, pv);
+    return (uint32_t)_mm_movemask_epi8(_mm_and_si128(sse2_op8(c, p, arg, op), valid));
+  }
+  return (uint32_t)_mm_movemask_epi8(sse2_op8(c, p, arg, op));
+}
+
+static uint64_t match64_sse2(const uint8_t *cur, const uint8_t *prev,
+                             search_width_t width, search_op_t op, uint32_t operand) {
+  uint64_t bits = 0;
+  for (int i = 0; i < 64; i += 16) {
+    bits |= (uint64_t)sse2_mask16(cur + i, prev + i, width, op, operand) << i;
+  }
+  return bits;
+}
+#endif
+
+/* ---------------- AVX2 ---------------- */
+
+#ifdef SEARCH_HAVE_AVX2
+__attribute__((target("avx2")))
+static inline __m256i avx2_op8(__m256i c, __m256i p, __m256i arg, search_op_t op) {
+  __m256i eq = _mm256_cmpeq_epi8(c, p);
+  switch (op) {
+    case SEARCH_EQ:        return _mm256_cmpeq_epi8(c, arg);
+    case SEARCH_CHANGED:   return _mm256_xor_si256(eq, _mm256_set1_epi8(-1));
+    case SEARCH_UNCHANGED: return eq;
+    case SEARCH_INC:       return _mm256_andnot_si256(eq, _mm256_cmpeq_epi8(_mm256_max_epu8(c, p), c));
+    case SEARCH_DEC:       return _mm256_andnot_si256(eq, _mm256_cmpeq_epi8(_mm256_min_epu8(c, p), c));
+    case SEARCH_INC_BY:    return _mm256_cmpeq_epi8(c, _mm256_add_epi8(p, arg));
+    case SEARCH_DEC_BY:    return _mm256_cmpeq_epi8(c, _mm256_sub_epi8(p, arg));
+    default:               return _mm256_setzero_si256();
+  }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_op16(__m256i c, __m256i p, __m256i arg, search_op_t op) {
+  const __m256i sign = _mm256_set1_epi16((short)0x8000);
+  __m256i eq = _mm256_cmpeq_epi16(c, p);
+  switch (op) {
+    case SEARCH_EQ:        return _mm256_cmpeq_epi16(c, arg);
+    case SEARCH_CHANGED:   return _mm256_xor_si256(eq, _mm256_set1_epi8(-1));
+    case SEARCH_UNCHANGED: return eq;
+    case SEARCH_INC:       return _mm256_cmpgt_epi16(_mm256_xor_si256(c, sign), _mm256_xor_si256(p, sign));
+    case SEARCH_DEC:       return _mm256_cmpgt_epi16(_mm256_xor_si256(p, sign), _mm256_xor_si256(c, sign));
+    case SEARCH_INC_BY:    return _mm256_cmpeq_epi16(c, _mm256_add_epi16(p, arg));
+    case SEARCH_DEC_BY:    return _mm256_cmpeq_epi16(c, _mm256_sub_epi16(p, arg));
+    default:               return _mm256_setzero_si256();
+  }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2_bcd(__m256i b, __m256i *valid) {
+  const __m256i nib = _mm256_set1_epi8(0x0F);
+  const __m256i nine = _mm256_set1_epi8(9);
+  __m256i lo = _mm256_and_si256(b, nib);
+  __m256i hi = _mm256_and_si256(_mm256_srli_epi16(b, 4), nib);
+  *valid = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(lo, nine), lo),
+                            _mm256_cmpeq_epi8(_mm256_min_epu8(hi, nine), hi));
+  __m256i hi2 = _mm256_add_epi8(hi, hi);
+  __m256i hi6 = _mm256_add_epi8(_mm256_add_epi8(hi2, hi2), hi2);
+  return _mm256_sub_epi8(b, hi6);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t avx2_mask32(const uint8_t *cur, const uint8_t *prev,
+                                   search_width_t width, search_op_t op, uint32_t operand) {
+  __m256i c = _mm256_loadu_si256((const __m256i*)cur);
+  __m256i p = _mm256_loadu_si256((const __m256i*)prev);
+
+  if (width == SEARCH_U16) {
+    __m256i arg = _mm256_set1_epi16((short)operand);
+    __m256i c1 = _mm256_loadu_si256((const __m256i*)(cur + 1));
+    __m256i p1 = _mm256_loadu_si256((const __m256i*)(prev + 1));
+    uint32_t even = (uint32_t)_mm256_movemask_epi8(avx2_op16(c, p, arg, op)) & 0x55555555u;
+    uint32_t odd = (uint32_t)_mm256_movemask_epi8(avx2_op16(c1, p1, arg, op)) & 0x55555555u;
+    return even | (odd << 1);
+  }
+
+  __m256i arg = _mm256_set1_epi8((char)operand);
+  if (width == SEARCH_BCD8) {
+    __m256i cv, pv;
+    c = avx2_bcd(c, &cv);
+    p = avx2_bcd(p, &pv);
+    __m256i valid = (op == SEARCH_EQ) ? cv : _mm256_and_si256(cv, pv);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(avx2_op8(c, p, arg, op), valid));
+  }
+  return (uint32_t)_mm256_movemask_epi8(avx2_op8(c, p, arg, op));
+}
+
+__attribute__((target("avx2")))
+static uint64_t match64_avx2(const uint8_t *cur, const uint8_t *prev,
+                             search_width_t width, search_op_t op, uint32_t operand) {
+  uint64_t lo = avx2_mask32(cur, prev, width, op, operand);
+  uint64_t hi = avx2_mask32(cur + 32, prev + 32, width, op, operand);
+  return lo | (hi << 32);
+}
+#endif
+
+static match64_fn pick_kernel(void) {
+#ifdef SEARCH_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) return match64_avx2;
+#endif
+#if defined(__SSE2__)
+  return match64_sse2;
+#else
+  return match64_scalar;
+#endif
+}
+
+/* ---------------- API ---------------- */
+
+Ram_Search_t *search_begin(Bus_t *bus, search_region_t region, search_width_t width) {
+  size_t size;
+  uint8_t *mem = region_ptr(bus, region, &size);
+  if (!mem || size == 0) {
+    fprintf(stderr, "[SEARCH] region %d has no memory\n", region);
+    return NULL;
+  }
+
+  Ram_Search_t *s = (Ram_Search_t*)calloc(1, sizeof(Ram_Search_t));
+  if (!s) return NULL;
+  size_t words = (size + 63) / 64;
+  s->region = region;
+  s->width = width;
+  s->size = size;
+  s->snapshot = (uint8_t*)malloc(size);
+  s->candidates = (uint64_t*)malloc(words * sizeof(uint64_t));
+  if (!s->snapshot || !s->candidates) {
+    search_free(s);
+    return NULL;
+  }
+
+  memcpy(s->snapshot, mem, size);
+  memset(s->candidates, 0xFF, words * sizeof(uint64_t));
+  if (size % 64)
+    s->candidates[words - 1] = (1ull << (size % 64)) - 1;
+  s->count = size;
+  return s;
+}
+
+size_t search_step(Ram_Search_t *s, Bus_t *bus, search_op_t op, uint32_t operand) {
+  size_t size;
+  const uint8_t *cur = region_ptr(bus, s->region, &size);
+  if (!cur || size != s->size) return s->count;
+
+  bool never = (s->width == SEARCH_BCD8 && operand > 99 &&
+                (op == SEARCH_EQ || op == SEARCH_INC_BY || op == SEARCH_DEC_BY));
+  match64_fn match64 = pick_kernel();
+  size_t words = (size + 63) / 64;
+  size_t count = 0;
+
+  for (size_t w = 0; w < words; w++) {
+    uint64_t cand = s->candidates[w];
+    if (!cand) continue;
+    size_t base = w * 64;
+
+    uint64_t hits = 0;
+    if (never) {
+      hits = 0;
+    } else if (base + 65 <= size) {
+      hits = match64(cur + base, s->snapshot + base, s->width, op, operand);
+    } else {
+      for (size_t i = base; i < size && i < base + 64; i++) {
+        if (match_one(cur, s->snapshot, i, size, s->width, op, operand))
+          hits |= 1ull << (i - base);
+      }
+    }
+    s->candidates[w] = cand & hits;
+    count += (size_t)__builtin_popcountll(s->candidates[w]);
+  }
+
+  memcpy(s->snapshot, cur, size);
+  s->count = count;
+  return count;
+}
+
+size_t search_results(const Ram_Search_t *s, uint32_t *offsets, size_t max) {
+  size_t n = 0;
+  size_t words = (s->size + 63) / 64;
+  for (size_t w = 0; w < words && n < max; w++) {
+    uint64_t bits = s->candidates[w];
+    while (bits && n < max) {
+      offsets[n++] = (uint32_t)(w * 64 + (size_t)__builtin_ctzll(bits));
+      bits &= bits - 1;
+    }
+  }
+  return n;
+}
+
+void search_free(Ram_Search_t *s) {
+  if (!s) return;
+  free(s->snapshot);
+  free(s->candidates);
+  free(s);
+}
@@ -0,0 +1,421 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+#include "unpack.h"
+
+// Largest ROM the header can describe is 8MB; anything bigger is not a ROM
+#define UNPACK_MAX_SIZE (8u * 1024u * 1024u)
+#define FAST_BITS 10
+
+/* ------------- inflate (RFC 1951) ------------- */
+
+typedef struct Huff {
+  uint16_t counts[16];
+  uint16_t symbols[288];
+  uint16_t fast[1 << FAST_BITS]; // symbol << 4 | length, 0 for codes longer than FAST_BITS
+} Huff_t;
+
+typedef struct Inflate {
+  const uint8_t *src;
+  const uint8_t *end;
+  uint32_t bits;
+  int nbits;
+  size_t overrun;  // zero bytes fed in past the end of src
+  uint8_t *dst;
+  size_t pos;
+  size_t cap;
+} Inflate_t;
+
+static const uint16_t len_base[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t len_extra[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Keeps at least 25 bits buffered, padding with zeros past the end so the
+// fast table can peek; overrun tells whether any padding got consumed.
+static inline void refill(Inflate_t *s) {
+  while (s->nbits <= 24) {
+    if (s->src < s->end) s->bits |= (uint32_t)*s->src++ << s->nbits;
+    else s->overrun++;
+    s->nbits += 8;
+  }
+}
+
+static inline uint32_t getbits(Inflate_t *s, int n) {
+  if (s->nbits < n) refill(s);
+  uint32_t v = s->bits & ((1u << n) - 1);
+  s->bits >>= n;
+  s->nbits -= n;
+  return v;
+}
+
+static inline bool overran(const Inflate_t *s) {
+  return s->overrun * 8 > (size_t)s->nbits;
+}
+
+static int huff_build(Huff_t *h, const uint8_t *lens, int n) {
+  uint16_t offs[16];
+  uint16_t next[16];
+
+  memset(h->counts, 0, sizeof(h->counts));
+  memset(h->fast, 0, sizeof(h->fast));
+  for (int i = 0; i < n; i++) h->counts[lens[i]]++;
+  h->counts[0] = 0;
+
+  // oversubscribed sets can't be decoded; incomplete ones are legal
+  int left = 1;
+  for (int len = 1; len < 16; len++) {
+    left <<= 1;
+    left -= h->counts[len];
+    if (left < 0) return -1;
+  }
+
+  offs[1] = 0;
+  next[1] = 0;
+  for (int len = 1; len < 15; len++) {
+    offs[len + 1] = offs[len] + h->counts[len];
+    next[len + 1] = (uint16_t)((next[len] + h->counts[len]) << 1);
+  }
+
+  for (int sym = 0; sym < n; sym++) {
+    int len = lens[sym];
+    if (!len) continue;
+    h->symbols[offs[len]++] = (uint16_t)sym;
+
+    uint16_t code = next[len]++;
+    if (len > FAST_BITS) continue;
+    // the stream stores codes MSB first, the table is indexed LSB first
+    uint16_t rev = 0;
+    for (int b = 0; b < len; b++) rev |= (uint16_t)(((code >> b) & 1) << (len - 1 - b));
+    for (int k = rev; k < (1 << FAST_BITS); k += 1 << len)
+      h->fast[k] = (uint16_t)((sym << 4) | len);
+  }
+  return 0;
+}
+
+static int huff_decode(Inflate_t *s, const Huff_t *h) {
+  if (s->nbits < 15) refill(s);
+  uint16_t e = h->fast[s->bits & ((1u << FAST_BITS) - 1)];
+  if (e) {
+    s->bits >>= (e & 0xF);
+    s->nbits -= (e & 0xF);
+    return e >> 4;
+  }
+
+  // long codes, one bit at a time
+  int code = 0, first = 0, index = 0;
+  for (int len = 1; len < 16; len++) {
+    code |= (int)getbits(s, 1);
+    int count = h->counts[len];
+    if (code - count < first) return h->symbols[index + (code - first)];
+    index += count;
+    first += count;
+    first <<= 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+static int inflate_stored(Inflate_t *s) {
+  getbits(s, s->nbits & 7);
+  uint32_t len = getbits(s, 16);
+  uint32_t nlen = getbits(s, 16);
+  if ((len ^ 0xFFFFu) != nlen || len > s->cap - s->pos) return -1;
+
+  // whatever is still sitting in the bit buffer comes first
+  while (len && s->nbits >= 8) {
+    s->dst[s->pos++] = (uint8_t)getbits(s, 8);
+    len--;
+  }
+  if (overran(s) || len > (size_t)(s->end - s->src)) return -1;
+  memcpy(s->dst + s->pos, s->src, len);
+  s->src += len;
+  s->pos += len;
+  return 0;
+}
+
+static int inflate_codes(Inflate_t *s, const Huff_t *lit, const Huff_t *dist) {
+  for (;;) {
+    int sym = huff_decode(s, lit);
+    if (sym < 0 || overran(s)) return -1;
+
+    if (sym < 256) {
+      if (s->pos >= s->cap) return -1;
+      s->dst[s->pos++] = (uint8_t)sym;
+      continue;
+    }
+    if (sym == 256) return 0;
+
+    sym -= 257;
+    if (sym >= 29) return -1;
+    size_t len = len_base[sym] + getbits(s, len_extra[sym]);
+
+    int dsym = huff_decode(s, dist);
+    if (dsym < 0 || dsym >= 30) return -1;
+    size_t d = dist_base[dsym] + getbits(s, dist_extra[dsym]);
+
+    if (d > s->pos || len > s->cap - s->pos) return -1;
+    uint8_t *out = s->dst + s->pos;
+    const uint8_t *from = out - d;
+    // overlapping copies repeat the last d bytes, so no memcpy here
+    for (size_t i = 0; i < len; i++) out[i] = from[i];
+    s->pos += len;
+  }
+}
+
+static Huff_t fixed_lit, fixed_dist;
+static uint32_t crc_table[256];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void build_tables(void) {
+  uint8_t lens[288];
+  int i = 0;
+  for (; i < 144; i++) lens[i] = 8;
+  for (; i < 256; i++) lens[i] = 9;
+  for (; i < 280; i++) lens[i] = 7;
+  for (; i < 288; i++) lens[i] = 8;
+  huff_build(&fixed_lit, lens, 288);
+  for (i = 0; i < 30; i++) lens[i] = 5;
+  huff_build(&fixed_dist, lens, 30);
+
+  for (uint32_t n = 0; n < 256; n++) {
+    uint32_t c = n;
+    for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    crc_table[n] = c;
+  }
+}
+
+static int inflate_fixed(Inflate_t *s) {
+  return inflate_codes(s, &fixed_lit, &fixed_dist);
+}
+
+static int inflate_dynamic(Inflate_t *s) {
+  static const uint8_t order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+  };
+  uint8_t lens[288 + 32];
+  Huff_t lit, dist;
+
+  int nlen = (int)getbits(s, 5) + 257;
+  int ndist = (int)getbits(s, 5) + 1;
+  int ncode = (int)getbits(s, 4) + 4;
+  if (nlen > 286 || ndist > 30) return -1;
+
+  memset(lens, 0, 19);
+  for (int i = 0; i < ncode; i++) lens[order[i]] = (uint8_t)getbits(s, 3);
+  if (huff_build(&lit, lens, 19) != 0) return -1;
+
+  int i = 0;
+  while (i < nlen + ndist) {
+    int sym = huff_decode(s, &lit);
+    if (sym < 0 || overran(s)) return -1;
+    if (sym < 16) {
+      lens[i++] = (uint8_t)sym;
+      continue;
+    }
+
+    uint8_t val = 0;
+    int rep;
+    if (sym == 16) {
+      if (i == 0) return -1;
+      val = lens[i - 1];
+      rep = 3 + (int)getbits(s, 2);
+    } else if (sym == 17) {
+      rep = 3 + (int)getbits(s, 3);
+    } else {
+      rep = 11 + (int)getbits(s, 7);
+    }
+    if (i + rep > nlen + ndist) return -1;
+    while (rep--) lens[i++] = val;
+  }
+
+  if (lens[256] == 0) return -1;
+  if (huff_build(&lit, lens, nlen) != 0 || huff_build(&dist, lens + nlen, ndist) != 0)
+    return -1;
+  return inflate_codes(s, &lit, &dist);
+}
+
+// Decodes one raw DEFLATE stream into dst. Returns bytes written or -1.
+static long inflate_raw(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+  pthread_once(&tables_once, build_tables);
+
+  Inflate_t s;
+  memset(&s, 0, sizeof(s));
+  s.src = src;
+  s.end = src + len;
+  s.dst = dst;
+  s.cap = cap;
+
+  int last;
+  do {
+    last = (int)getbits(&s, 1);
+    int type = (int)getbits(&s, 2);
+    int rc;
+    switch (type) {
+      case 0: rc = inflate_stored(&s); break;
+      case 1: rc = inflate_fixed(&s); break;
+      case 2: rc = inflate_dynamic(&s); break;
+      default: rc = -1; break;
+    }
+    if (rc != 0 || overran(&s)) return -1;
+  } while (!last);
+
+  return (long)s.pos;
+}
+
+/* ------------- containers ------------- */
+
+static uint32_t crc32_buf(const uint8_t *p, size_t n) {
+  pthread_once(&tables_once, build_tables);
+
+  uint32_t c = 0xFFFFFFFFu;
+  for (size_t i = 0; i < n; i++) c = crc_table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+  return c ^ 0xFFFFFFFFu;
+}
+
+static inline uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool is_gzip(const uint8_t *d, size_t len) {
+  return len >= 2 && d[0] == 0x1F && d[1] == 0x8B;
+}
+
+static bool is_zip(const uint8_t *d, size_t len) {
+  return len >= 4 && le32(d) == 0x04034B50u;
+}
+
+bool unpack_is_compressed(const uint8_t *data, size_t len) {
+  return is_gzip(data, len) || is_zip(data, len);
+}
+
+// Allocates the bank-padded output for a known uncompressed size
+static uint8_t *alloc_rom(size_t size, size_t *padded) {
+  if (size == 0 || size > UNPACK_MAX_SIZE) return NULL;
+  *padded = (size + 0x3FFFu) & ~(size_t)0x3FFFu;
+  uint8_t *buf = (uint8_t*)malloc(*padded);
+  if (buf) memset(buf + size, 0xFF, *padded - size);
+  return buf;
+}
+
+static uint8_t *unpack_gzip(const uint8_t *d, size_t len, size_t *size, size_t *padded) {
+  if (len < 18) return NULL;
+  if (d[2] != 8) {
+    fprintf(stderr, "[ROM] gzip method %u not supported\n", d[2]);
+    return NULL;
+  }
+  uint8_t flg = d[3];
+  size_t p = 10;
+  if (flg & 0x04) p += 2 + (size_t)le16(d + p);         // FEXTRA
+  if (flg & 0x08) while (p < len && d[p++]) {}          // FNAME
+  if (flg & 0x10) while (p < len && d[p++]) {}          // FCOMMENT
+  if (flg & 0x02) p += 2;                               // FHCRC
+  if (p + 8 > len) return NULL;
+
+  uint32_t crc = le32(d + len - 8);
+  *size = le32(d + len - 4);
+  uint8_t *buf = alloc_rom(*size, padded);
+  if (!buf) return NULL;
+
+  long got = inflate_raw(d + p, len - 8 - p, buf, *size);
+  if (got != (long)*size || crc32_buf(buf, *size) != crc) {
+    fprintf(stderr, "[ROM] corrupt gzip stream\n");
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
+
+static bool is_rom_name(const uint8_t *name, size_t n) {
+  static const char *exts[] = { ".gb", ".gbc", ".sgb" };
+  for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+    size_t e = strlen(exts[i]);
+    if (n >= e && strncasecmp((const char*)name + n - e, exts[i], e) == 0) return true;
+  }
+  return false;
+}
+
+static uint8_t *unpack_zip(const uint8_t *d, size_t len, size_t *size, size_t *padded) {
+  if (len < 30) return NULL;
+
+  // end of central directory, possibly followed by a comment
+  size_t eocd = 0;
+  size_t lo = (len > 0xFFFF + 22) ? len - 0xFFFF - 22 : 0;
+  for (size_t i = len - 22 + 1; i-- > lo;) {
+    if (le32(d + i) == 0x06054B50u) {
+      eocd = i;
+      break;
+    }
+  }
+  if (!eocd) {
+    fprintf(stderr, "[ROM] zip has no central directory\n");
+    return NULL;
+  }
+
+  uint16_t entries = le16(d + eocd + 10);
+  size_t p = le32(d + eocd + 16);
+  const uint8_t *pick = NULL;
+  for (uint16_t i = 0; i < entries; i++) {
+    if (p + 46 > len || le32(d + p) != 0x02014B50u) return NULL;
+    size_t nlen = le16(d + p + 28);
+    if (p + 46 + nlen > len) return NULL;
+    if (!pick) pick = d + p;
+    if (is_rom_name(d + p + 46, nlen)) {
+      pick = d + p;
+      break;
+    }
+    p += 46 + nlen + le16(d + p + 30) + le16(d + p + 32);
+  }
+  if (!pick) return NULL;
+
+  uint16_t method = le16(pick + 10);
+  uint32_t crc = le32(pick + 16);
+  size_t csize = le32(pick + 20);
+  *size = le32(pick + 24);
+  size_t local = le32(pick + 42);
+  if (method != 0 && method != 8) {
+    fprintf(stderr, "[ROM] zip method %u not supported\n", method);
+    return NULL;
+  }
+  if (local + 30 > len || le32(d + local) != 0x04034B50u) return NULL;
+  size_t data = local + 30 + le16(d + local + 26) + le16(d + local + 28);
+  if (data > len || csize > len - data) return NULL;
+
+  uint8_t *buf = alloc_rom(*size, padded);
+  if (!buf) return NULL;
+
+  long got;
+  if (method == 0) {
+    got = (csize == *size) ? (long)csize : -1;
+    if (got >= 0) memcpy(buf, d + data, csize);
+  } else {
+    got = inflate_raw(d + data, csize, buf, *size);
+  }
+  if (got != (long)*size || crc32_buf(buf, *size) != crc) {
+    fprintf(stderr, "[ROM] corrupt zip entry\n");
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
+
+uint8_t *unpack_rom(const uint8_t *data, size_t len, size_t *size, size_t *padded) {
+  if (is_gzip(data, len)) return unpack_gzip(data, len, size, padded);
+  if (is_zip(data, len)) return unpack_zip(data, len, size, padded);
+  return NULL;
+}
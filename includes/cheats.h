@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  GameShark and Game Genie codes.
+
+  Game Genie codes (ABC-DEF or ABC-DEF-GHI) are applied once, when added,
+  by patching shadow copies of the affected 16KB ROM banks and mapping
+  them in place of the originals. Codes below 0x4000 patch every bank
+  the ROM0 window can map (0x20/0x40/0x60 too on MBC1). GameShark codes
+  (8 hex digits) are RAM pokes written at every VBlank. Bus_t::cheats
+  stays NULL while no codes are active, so the bus and mapper read paths
+  never look at cheats.
+*/
+
+#define MAX_CHEATS 64
+
+typedef enum {
+  CHEAT_GAMESHARK = 0,
+  CHEAT_GAMEGENIE,
+} cheat_kind_t;
+
+typedef struct Cheat {
+  cheat_kind_t kind;
+  uint8_t type;    // GameShark: 01 plain, 8X cart RAM bank X, 9X WRAM bank X
+  uint16_t addy;
+  uint8_t value;
+  bool has_compare;
+  uint8_t compare; // Game Genie: only patch where ROM holds this byte
+} Cheat_t;
+
+typedef struct Cheats {
+  Cheat_t codes[MAX_CHEATS];
+  int count;
+  int pokes; // number of GameShark codes
+} Cheats_t;
+
+struct Bus;
+
+// 0 on success, -1 for a malformed code or a full list
+int cheat_add(struct Bus *bus, const char *code);
+void cheat_clear(struct Bus *bus);
+// Writes GameShark pokes; called by the PPU at the start of VBlank
+void cheat_apply_frame(struct Bus *bus);
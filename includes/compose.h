@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Final per-pixel compositing of one scanline. The renderer fills the BG
+  and OBJ layers with color ids and attributes, compose_line picks the
+  winning layer for every pixel and writes ARGB through a 128-entry color
+  table: slots 0-63 are BG palette * 4 + color id, 64-127 the same for
+  OBJ. On DMG, BG is palette 0 and OBJ uses palette 0/1 for OBP0/OBP1.
+
+  Kernels: AVX2 (32 pixels per step, gathered color lookup), SSE2 and
+  NEON (16 per step), scalar otherwise. Picked at runtime like search.c.
+*/
+
+#define COMPOSE_OBJ_SLOT 64
+#define COMPOSE_OBJ_BEHIND 0x80 // obj_attr: OAM bit 7, BG colors 1-3 win
+
+typedef struct Ppu_Line {
+  uint8_t bg_id[160];    // BG/window color id 0-3
+  uint8_t bg_attr[160];  // CGB map attributes, palette in bits 0-2
+  uint8_t obj_id[160];   // winning sprite color id, 0 where none
+  uint8_t obj_attr[160]; // palette in bits 0-2 | COMPOSE_OBJ_BEHIND
+} Ppu_Line_t;
+
+// cgb: honour BG map attribute bit 7. bg_master: LCDC bit 0 on CGB; when
+// clear, sprites always draw over BG.
+void compose_line(const Ppu_Line_t *line, bool cgb, bool bg_master,
+                  const uint32_t *colors, uint32_t *out);
+// Same, stopping at the 160 color table slots
+void compose_line_slots(const Ppu_Line_t *line, bool cgb, bool bg_master, uint8_t *slots);
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Dirty-page journal: one bit per 256-byte page of guest RAM, set on the
+  write paths and handed out (and cleared) once per frame.
+
+  Only compiled in with -DDIRTY_PAGES (make DIRTY_PAGES=1). Without it
+  DIRTY_MARK expands to nothing so the write paths are untouched.
+*/
+
+#define DIRTY_PAGE_SHIFT 8
+#define DIRTY_PAGE_SIZE (1u << DIRTY_PAGE_SHIFT)
+
+#define DIRTY_WRAM_WORDS 2     // 32KB
+#define DIRTY_VRAM_WORDS 1     // 16KB
+#define DIRTY_CART_RAM_WORDS 8 // up to 128KB
+
+#ifdef DIRTY_PAGES
+#define DIRTY_MARK(bits, off) \
+  ((bits)[(size_t)(off) >> 14] |= 1ull << (((size_t)(off) >> DIRTY_PAGE_SHIFT) & 63))
+#else
+#define DIRTY_MARK(bits, off) ((void)0)
+#endif
+
+typedef struct Dirty_Set {
+  uint64_t wram[DIRTY_WRAM_WORDS];
+  uint64_t vram[DIRTY_VRAM_WORDS];
+  uint64_t oam[1];  // single page
+  uint64_t hram[1]; // single page
+  uint64_t cart_ram[DIRTY_CART_RAM_WORDS];
+} Dirty_Set_t;
+
+struct Bus;
+
+static inline bool dirty_page_is_set(const uint64_t *bits, size_t page) {
+  return (bits[page >> 6] >> (page & 63)) & 1u;
+}
+
+// Copies the pages written since the last call into out and clears the
+// journal. out is all zero when the build has no DIRTY_PAGES.
+void bus_dirty_take(struct Bus *bus, Dirty_Set_t *out);
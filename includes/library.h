@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "mbc.h"
+
+/*
+  ROM library index. library_scan walks a directory tree, and a pool of
+  worker threads parses the cartridge header and computes rom_hash for
+  every .gb/.gbc/.sgb file. .gz/.zip files are inflated first and indexed
+  by the ROM inside, with the same hash the ROM cache keys them by. Files
+  whose size and mtime match the existing index are not opened again. The
+  index is a tab-separated text file, one ROM per line, so it can be
+  loaded in a few milliseconds and diffed by hand.
+*/
+
+#define LIBRARY_INDEX_NAME "romlib.idx"
+
+typedef struct Rom_Entry {
+  char *path;
+  uint64_t size;          // of the file, compressed or not
+  int64_t mtime;
+  uint64_t hash;          // rom_hash of the uncompressed ROM, as in the ROM cache
+
+  char title[17];
+  bool is_cgb;
+  bool is_sgb;
+  uint8_t cart_type;      // raw 0x147
+  mbc_t mbc;
+  size_t rom_size;        // from the header, 0 if the code is unknown
+  size_t ram_size;
+  uint8_t header_checksum;
+  bool header_ok;         // 0x14D matches the computed value
+  uint16_t global_checksum;
+} Rom_Entry_t;
+
+typedef struct Rom_Library {
+  char *index_path;
+  Rom_Entry_t *entries;   // sorted by path
+  size_t count;
+  size_t cap;
+  bool changed;           // last library_scan added, rehashed or dropped entries
+} Rom_Library_t;
+
+// Loads index_path if it exists, otherwise starts empty. NULL on OOM.
+Rom_Library_t *library_open(const char *index_path);
+// Rescans dir with the given number of threads (0 picks one per CPU).
+// Entries for files that are gone are dropped. Returns how many files were
+// (re)hashed, -1 on error; lib->changed tells whether the index needs saving.
+int library_scan(Rom_Library_t *lib, const char *dir, int threads);
+// Writes the index back to index_path. 0 on success.
+int library_save(const Rom_Library_t *lib);
+const Rom_Entry_t *library_find_path(const Rom_Library_t *lib, const char *path);
+const Rom_Entry_t *library_find_hash(const Rom_Library_t *lib, uint64_t hash);
+void library_free(Rom_Library_t *lib);
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <time.h>
+#include "dirty.h"
 
 typedef enum {
   MBC_0 = 0,
@@ -11,13 +12,30 @@ typedef enum {
   MBC_5
 } mbc_t;
 
+struct Rom_Image;
+struct Save_File;
+struct Cartridge;
+
+// Per-MBC behaviour. map_banks picks the bank numbers from the mapper
+// registers; read_ram/write only see accesses the fast path can't serve.
+typedef struct Mapper {
+  const char *name;
+  void (*map_banks)(struct Cartridge *cart);
+  uint8_t (*read_ram)(struct Cartridge *cart, uint16_t addy);
+  void (*write)(struct Cartridge *cart, uint16_t addy, uint8_t val);
+} Mapper_t;
+
 typedef struct Cartridge {
   mbc_t type;
+  const Mapper_t *mapper;
+  struct Rom_Image *rom_image; // shared, read-only
   uint8_t *rom;
   size_t rom_size;
+  uint8_t **rom_map; // per 16KB bank, rom or a patched shadow copy
 
   uint8_t *ram; 
   size_t ram_size; 
+  struct Save_File *save; // battery backing, NULL if none
   bool ram_enable;
 
   uint8_t rom_bank;
@@ -27,13 +45,23 @@ typedef struct Cartridge {
   uint16_t rom_banks;
   uint16_t ram_banks;
 
+  // current banking, recomputed by cart_map_banks on every register write
+  uint8_t *rom0;	// 0x0000-0x3FFF
+  uint8_t *romx;	// 0x4000-0x7FFF
+  uint8_t *sram;	// 0xA000-0xBFFF, NULL unless a full 8KB RAM bank is mapped
+  uint32_t rom0_bank;
+  uint32_t romx_bank;
+  long sram_off;	// offset into ram, -1 if RAM is not mapped
+
   uint8_t rtc_regs[5];	// 0 S | 1 M | 2 H | 3 DL | 4 DH
   uint8_t rtc_reg_select;
   bool rtc_latched;
   uint8_t rtc_latched_regs[5];
   bool rtc_halt;
   bool rtc_day_carry;
-  time_t rtc_last_update;
+  const uint64_t *rtc_clock; // emulated 4194304 Hz cycles, also during STOP
+  uint64_t rtc_last_cycles;
+  int64_t rtc_saved_stamp;   // unix time the .sav was written, 0 if none
   uint32_t rtc_total_seconds;
   uint8_t rtc_latch_prev;
 
@@ -42,10 +70,43 @@ typedef struct Cartridge {
   
   // SGB
   bool is_sgb;
+
+#ifdef DIRTY_PAGES
+  uint64_t ram_dirty[DIRTY_CART_RAM_WORDS];
+#endif
 } Cartridge_t;
 
+// Header decoding for 0x147-0x149
+mbc_t get_cartridge_type(uint8_t type);
+size_t get_cartridge_rom_size(uint8_t val);
+size_t get_cartridge_ram_size(uint8_t val);
+
 Cartridge_t *load_cart(const char *path);
 void free_cart(Cartridge_t *cart);
 void cart_write(Cartridge_t *cart, uint16_t addy, uint8_t val); 
-uint8_t cart_read(Cartridge_t *cart, uint16_t addy);
+uint8_t cart_read_slow(Cartridge_t *cart, uint16_t addy);
+// Recomputes rom0/romx/sram after the mapper state or rom_map changed
+void cart_map_banks(Cartridge_t *cart);
+
+static inline uint8_t cart_read(Cartridge_t *cart, uint16_t addy) {
+  if (addy < 0x4000) return cart->rom0[addy];
+  if (addy < 0x8000) return cart->romx[addy - 0x4000];
+  if (cart->sram && addy >= 0xA000 && addy <= 0xBFFF) return cart->sram[addy - 0xA000];
+  return cart_read_slow(cart, addy);
+}
+// Host pointer for addy under the current banking, or NULL if the access
+// is not plain ROM/RAM. *span, if span isn't NULL, is the number of
+// contiguous bytes.
+uint8_t *cart_host_ptr(Cartridge_t *cart, uint16_t addy, uint16_t *span);
+// ROM bank currently mapped at addy (0x0000-0x7FFF)
+uint32_t cart_rom_bank(const Cartridge_t *cart, uint16_t addy);
+// Private writable copy of a ROM bank, mapped in place of the original
+uint8_t *cart_rom_shadow(Cartridge_t *cart, uint16_t bank);
+void cart_rom_unshadow(Cartridge_t *cart);
+// MBC3 RTC state in the 48-byte .sav footer layout
+void cart_rtc_store(Cartridge_t *cart, uint8_t *out);
+void cart_rtc_load(Cartridge_t *cart, const uint8_t *in);
+// Advances the RTC by the wall time since the save was written. Without
+// this the clock only follows emulated time, which keeps runs deterministic.
+void cart_rtc_sync_wallclock(Cartridge_t *cart);
 
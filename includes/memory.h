@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include "mbc.h"
 #include "timers.h"
+#include "dirty.h"
 
 /*
 
@@ -38,6 +39,8 @@ typedef struct Bus {
   uint8_t vram[0x4000];
   uint8_t oam[0xA0];
 
+  uint64_t cycles; // emulated time in 4194304 Hz cycles
+
   uint8_t IE;
   uint8_t IF;
   uint8_t JOYP;
@@ -56,6 +59,15 @@ typedef struct Bus {
   // Button states (0=pressed, 1=released)
   uint8_t buttons_dir;    // Direction buttons: bits 0=Right, 1=Left, 2=Up, 3=Down
   uint8_t buttons_action; // Action buttons: bits 0=A, 1=B, 2=Select, 3=Start
+
+  struct Cheats *cheats; // NULL unless codes are active
+
+#ifdef DIRTY_PAGES
+  Dirty_Set_t dirty; // cart RAM pages live in Cartridge_t::ram_dirty
+#endif
+#ifdef PROFILE_MEM
+  struct Mem_Prof *prof;
+#endif
 } Bus_t;
 
 void init_bus(Bus_t* b);
@@ -63,6 +75,12 @@ uint8_t read_byte_bus(Bus_t* bus, uint16_t addy);
 void write_byte_bus(Bus_t* bus, uint16_t addy, uint8_t val);
 int bus_load_rom(Bus_t *bus, const char* path);
 void bus_update_serial(Bus_t *bus, int cycles);
+// Host pointer backing addy when it is plain memory under the current
+// banking (ROM, VRAM, cart RAM, WRAM), else NULL. *span, if span isn't
+// NULL, is how many bytes follow contiguously.
+uint8_t *bus_host_ptr(Bus_t *bus, uint16_t addy, uint16_t *span);
+// CGB VRAM DMA copy of len bytes from src to dst in the current VRAM bank.
+void bus_vram_dma(Bus_t *bus, uint16_t src, uint16_t dst, uint16_t len);
 
 static inline uint16_t bus_read16(Bus_t* b, uint16_t addr) {
   uint8_t lo = read_byte_bus(b, addr);
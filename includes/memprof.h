@@ -0,0 +1,34 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Guest memory access heatmap. Counts CPU reads and writes per 16-byte
+  line of backing memory, so ROM, VRAM, WRAM and cart RAM are split by
+  bank. I/O, HRAM and IE are counted per address.
+
+  Only compiled in with -DPROFILE_MEM (make PROFILE_MEM=1); otherwise the
+  MEMPROF_* hooks expand to nothing.
+*/
+
+#define MEMPROF_LINE_SHIFT 4
+
+struct Bus;
+
+#ifdef PROFILE_MEM
+#define MEMPROF_READ(bus, addy) memprof_access((bus), (addy), false)
+#define MEMPROF_WRITE(bus, addy) memprof_access((bus), (addy), true)
+#else
+#define MEMPROF_READ(bus, addy) ((void)0)
+#define MEMPROF_WRITE(bus, addy) ((void)0)
+#endif
+
+#ifdef PROFILE_MEM
+void memprof_access(struct Bus *bus, uint16_t addy, bool write);
+// One CSV row per touched line: region,bank,address,reads,writes
+int memprof_write_heatmap(struct Bus *bus, const char *filename);
+// Top hot lines overall, then every touched I/O register
+void memprof_summary(struct Bus *bus, FILE *out, int top_n);
+void memprof_free(struct Bus *bus);
+#endif
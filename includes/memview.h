@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Zero-copy views of guest memory for in-process consumers. Each view
+  points straight at the emulator's backing array for one bank, so reads
+  need no copy and no bus decode. The pointers stay valid for the life of
+  the bus and cartridge, except ROM views, which move when cheat codes
+  are added or cleared.
+*/
+
+typedef enum {
+  MEM_WRAM = 0, // 8 banks of 4KB (bank 0 is C000, 1-7 switch at D000)
+  MEM_VRAM,     // 2 banks of 8KB
+  MEM_OAM,
+  MEM_HRAM,
+  MEM_CART_RAM, // 8KB banks
+  MEM_ROM,      // 16KB banks
+  MEM_REGION_COUNT,
+} mem_region_t;
+
+typedef struct Mem_View {
+  mem_region_t region;
+  uint16_t bank;
+  uint16_t addy;      // guest address the bank is mapped at
+  const uint8_t *data;
+  size_t size;
+} Mem_View_t;
+
+struct Bus;
+
+uint16_t bus_mem_bank_count(struct Bus *bus, mem_region_t region);
+bool bus_mem_view(struct Bus *bus, mem_region_t region, uint16_t bank, Mem_View_t *out);
+// Fills up to max views for every bank of every region, returns the total
+size_t bus_mem_views(struct Bus *bus, Mem_View_t *out, size_t max);
@@ -1,6 +1,8 @@
 #pragma once
 #include <stdint.h> 
 #include <stdbool.h> 
+#include <stddef.h>
+#include "compose.h"
 
 #define GB_WIDTH 160
 #define GB_HEIGHT 144
@@ -8,7 +10,71 @@
 
 #define LCDC_ENABLE 0x80
 
+// Renderer output formats. ARGB8888 is written to framebuffer, the others
+// to Ppu_t::output, converted straight from the compose slots per line.
+// Either way consumers read finished frames through ppu_acquire_frame.
+typedef enum {
+  PPU_FORMAT_ARGB8888 = 0,
+  PPU_FORMAT_INDEXED,    // uint8_t per pixel, colors from ppu_output_palette
+  PPU_FORMAT_RGB565,     // uint16_t per pixel
+  PPU_FORMAT_GRAY8,      // uint8_t luma per pixel
+  PPU_FORMAT_GRAY_SMALL, // PPU_GRAY_SMALL_SIZE square, box-filtered luma
+} Ppu_Format_t;
+
+#define PPU_GRAY_SMALL_SIZE 84
+
+#define PPU_FRAME_BUFFERS 3
+#define PPU_FRAME_FRESH 0x80 // Ppu_t::frame_shared: not yet acquired
+
 typedef struct Bus Bus_t;
+typedef struct Ppu_Render Ppu_Render_t;
+
+#define TILE_COUNT 384 // per VRAM bank, 0x8000-0x97FF
+
+// Tiles decoded to one color id (0-3) per byte, plus a horizontally
+// flipped copy. Entries are dropped on VRAM writes and decoded again on
+// first use.
+typedef struct Tile_Cache {
+  uint8_t px[2][TILE_COUNT][2][8][8]; // bank, tile, x flip, row, column
+  uint64_t valid[2][TILE_COUNT / 64];
+} Tile_Cache_t;
+
+#define SPRITES_PER_LINE 10
+
+// OAM indices visible on each line, highest priority first: the first 10
+// in OAM order, then sorted by X on DMG. Rebuilt when OAM or the sprite
+// size changes.
+typedef struct Sprite_Lists {
+  uint8_t count[GB_HEIGHT];
+  uint8_t index[GB_HEIGHT][SPRITES_PER_LINE];
+  uint32_t version; // oam_version the lists were built from
+  uint8_t height;
+} Sprite_Lists_t;
+
+// Pixel FIFO backend state for the line being drawn (Ppu_t::accurate).
+// BG pixels are pushed a tile at a time once the FIFO has drained; the
+// OBJ FIFO is a ring aligned with the next BG pixel out.
+typedef struct Ppu_Fifo {
+  uint8_t bg_id[8], bg_attr[8];
+  uint8_t bg_pos, bg_len;
+  uint8_t obj_id[8], obj_attr[8], obj_oam[8];
+  uint8_t obj_head;
+
+  uint8_t fetch_dot;       // BG fetcher progress, tile row ready at 6
+  uint8_t fetch_x;         // tiles fetched this line (or since window start)
+  uint8_t tile_num, tile_attr, tile_y;
+  uint8_t discard;         // pixels to drop: SCX fine scroll or WX < 7
+  uint8_t x;               // next LCD column
+  uint8_t stall;           // dots left on the initial or a sprite fetch
+  bool drawing;
+  bool in_window;
+  bool wy_hit;             // LY matched WY earlier this frame
+  uint8_t win_line;        // internal window line counter
+
+  uint8_t sprite_count;
+  uint8_t sprite[SPRITES_PER_LINE]; // OAM indices from this line's scan
+  uint16_t sprite_done;
+} Ppu_Fifo_t;
 
 enum {
   LCDC=0xFF40, STAT=0xFF41, SCY=0xFF42, SCX=0xFF43, LY=0xFF44, LYC=0xFF45,
@@ -18,11 +84,55 @@ enum {
 typedef struct Ppu {
   uint8_t LCDC, LY, LYC, STAT, SCY, SCX, BGP, OBP0, OBP1, WY, WX;
 
-  uint32_t *framebuffer;
-  uint32_t *scaled_framebuffer;
+  uint32_t *framebuffer;        // frame being drawn, NULL unless ARGB8888
+  uint32_t *scaled_framebuffer; // NULL when start_display gets scale 1
   uint32_t *background_buffer;
+  Tile_Cache_t *tiles;
 
   uint32_t pallete[4];
+  uint32_t colors[128]; // compose_line color table, kept current by palette writes
+  bool color_correct;   // CGB colors through the LCD response LUT
+  Ppu_Line_t line;
+  Sprite_Lists_t sprites;
+  uint32_t oam_version; // bumped on every OAM write and DMA byte
+
+  // Inputs to the line signatures: a line whose signature matches the one
+  // its row in the back buffer was drawn with is left alone
+  uint32_t palette_version;
+  uint32_t tile_block_version[3];   // 0x8000/0x8800/0x9000 blocks, both banks
+  uint32_t map_row_version[2][32];  // 0x9800/0x9C00 map rows, tiles and attributes
+  uint64_t line_sig[PPU_FRAME_BUFFERS][GB_HEIGHT];
+  uint16_t lines_rendered, lines_reused;             // frame in progress
+  // last complete frame; with the render thread, the last one it published
+  uint16_t frame_lines_rendered, frame_lines_reused;
+
+  Ppu_Format_t format;
+  void *output;               // frame being drawn, framebuffer for ARGB8888
+  uint8_t *gray_lines;        // full size luma behind PPU_FORMAT_GRAY_SMALL
+  bool small_dirty;           // a luma line feeding the current small row changed
+  uint32_t out_lut_version;   // palette_version the tables below were built from
+  uint8_t out_lut8[128];      // slot to index or luma
+  uint16_t out_lut16[128];    // slot to RGB565
+  uint8_t line_slots[GB_WIDTH]; // FIFO backend line for non-ARGB formats
+
+  // Triple buffering. The renderer draws into frames[frame_back] and at
+  // VBlank swaps it with the shared slot; ppu_acquire_frame swaps the
+  // consumer's frame with the shared one when that one is newer. Both
+  // sides only ever exchange indices, so neither waits on the other.
+  void *frames[PPU_FRAME_BUFFERS];
+  uint8_t *gray_frames;  // luma planes behind gray_lines, one per frame
+  uint8_t frame_back;    // emulation thread only
+  uint8_t frame_front;   // consumer thread only
+  uint8_t frame_shared;  // index | PPU_FRAME_FRESH, accessed atomically
+
+  // Line renderer on its own thread, NULL when lines are drawn inline.
+  // It owns the frames, signatures and line statistics while it runs.
+  Ppu_Render_t *render;
+
+  // Pixel FIFO renderer with variable mode 3 length instead of whole-line
+  // rendering, chosen once at startup
+  bool accurate;
+  Ppu_Fifo_t fifo;
 
 
   //gbc
@@ -33,6 +143,8 @@ typedef struct Ppu {
 
   int cycles_in_line;
   int mode;
+  int next_event;  // cycles_in_line of the next mode change or line end
+  bool stat_line;  // STAT interrupt line, IF is set when it rises
 
   // CGB VRAM DMA (HDMA) state
   uint8_t HDMA1, HDMA2, HDMA3, HDMA4, HDMA5;
@@ -40,6 +152,7 @@ typedef struct Ppu {
   uint16_t hdma_src;
   uint16_t hdma_dst;
   uint16_t hdma_remaining; // bytes remaining
+  int hdma_stall; // dots the CPU is halted for by VRAM DMA
 
   Bus_t *bus;
   uint8_t DMA; 
@@ -48,10 +161,55 @@ typedef struct Ppu {
   uint8_t dma_counter;
   uint16_t dma_source;
   bool frame_ready;
+
+  // Frame skip: draw 1 of every render_every frames, none when 0. Timing,
+  // interrupts and DMA run the same on skipped frames.
+  int render_every;
+  uint32_t frame_count;
+  bool skip_frame; // current frame is not being drawn
 } Ppu_t;
 
 void start_display(Ppu_t *display, Bus_t *bus, int scale);
 void display_cycle(Ppu_t *d, Bus_t *b, int cycles);
 uint8_t ppu_vram_read(Ppu_t *ppu, uint16_t addr);
 void ppu_vram_write(Ppu_t *ppu, uint16_t addr, uint8_t byte);
+void ppu_vram_write_block(Ppu_t *ppu, uint16_t addr, const uint8_t *src, uint16_t len);
 bool ppu_is_mode2(Ppu_t *ppu);
+// FF40/FF41/FF45 writes: restart or stop line timing, and re-evaluate
+// the STAT interrupt line
+void ppu_write_lcdc(Ppu_t *ppu, uint8_t val);
+void ppu_write_stat(Ppu_t *ppu, uint8_t val);
+void ppu_write_lyc(Ppu_t *ppu, uint8_t val);
+// Refresh Ppu_t::colors after a palette register write
+void ppu_update_dmg_colors(Ppu_t *ppu);
+void ppu_update_cgb_color(Ppu_t *ppu, bool obj, uint8_t index);
+// Maps CGB RGB555 through a precomputed LCD response curve, which
+// desaturates and mixes channels like the real screen
+void ppu_set_color_correction(Ppu_t *ppu, bool enable);
+// Reallocates the frame buffers and redraws every line from the next
+// frame. Not safe while another thread is in ppu_acquire_frame. Returns
+// -1, keeping the old format, while the render thread runs or if the
+// buffers can't be allocated.
+int ppu_set_format(Ppu_t *ppu, Ppu_Format_t format);
+size_t ppu_output_size(Ppu_Format_t format);
+// Colors behind PPU_FORMAT_INDEXED: on DMG the 4 shades, on CGB the 128
+// compose slots (BG palettes, then OBJ) as of the last line drawn
+const uint32_t *ppu_output_palette(const Ppu_t *ppu, int *count);
+// Moves line drawing to a render thread fed with per-line register
+// snapshots and a VRAM write journal. The fast renderer only: returns -1
+// with Ppu_t::accurate set, or if the thread can't start. Like
+// ppu_set_format, not safe while another thread is in ppu_acquire_frame:
+// the frames change hands.
+int ppu_start_render_thread(Ppu_t *ppu);
+// Blocks until every line queued so far has been drawn and published
+void ppu_render_flush(Ppu_t *ppu);
+// Drains the queue and goes back to drawing inline. Same restriction as
+// ppu_start_render_thread.
+void ppu_stop_render_thread(Ppu_t *ppu);
+// Latest complete frame in the current format, unchanged until the next
+// call. May run on another thread than display_cycle, but not alongside
+// ppu_set_format or starting/stopping the render thread. Never blocks;
+// *fresh (optional) tells whether a frame was published since last time.
+const void *ppu_acquire_frame(Ppu_t *ppu, bool *fresh);
+// Restarts the 1-of-N cadence: the current frame is drawn unless N is 0
+void ppu_set_frame_skip(Ppu_t *ppu, int render_every);
@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Process-wide cache of read-only ROM images. Files are mapped with
+  mmap(PROT_READ, MAP_PRIVATE) and deduplicated by content hash, so every
+  instance running the same game shares the same physical pages. Images
+  are reference counted and unmapped when the last cartridge lets go.
+  Compressed files (see unpack.h) are inflated into a private buffer
+  and deduplicated the same way, by the hash of the uncompressed ROM.
+*/
+
+typedef struct Rom_Image {
+  uint8_t *data;
+  size_t size;   // bytes of ROM content
+  size_t padded; // readable length, a whole number of 16KB banks
+  uint64_t hash;
+  bool mapped;   // mmap'd, otherwise malloc'd
+  int refs;
+
+  // file identity, to skip hashing on repeat loads of the same file
+  uint64_t dev, ino;
+  int64_t mtime;
+  size_t file_size; // differs from size for .gz/.zip
+
+  struct Rom_Image *next;
+} Rom_Image_t;
+
+uint64_t rom_hash(const uint8_t *data, size_t len);
+Rom_Image_t *rom_cache_acquire(const char *path);
+void rom_cache_release(Rom_Image_t *img);
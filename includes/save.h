@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "mbc.h"
+
+/*
+  Battery-backed save RAM. The .sav next to the ROM is mapped MAP_SHARED
+  and Cartridge_t::ram points into it, so game writes land in the page
+  cache with no syscalls. The emulation thread only sets dirty bits (one
+  per 4KB page) and, when the game disables RAM, asks for a flush. A
+  single background thread msyncs the dirty ranges on request and every
+  SAVE_FLUSH_INTERVAL seconds; save_close does a final synchronous flush.
+
+  MBC3 carts also keep the RTC in a 48-byte footer after RAM: five
+  registers, five latched registers (4 bytes LE each), then a 64-bit unix
+  timestamp. save_frame refreshes it at every VBlank, so the timer flush
+  persists the clock even if the game never disables RAM.
+
+  Only one session maps a given .sav (flock). Others running the same ROM
+  start from its contents in private RAM that is never written back.
+*/
+
+#define SAVE_FLUSH_INTERVAL 5
+#define SAVE_PAGE_SHIFT 12
+#define SAVE_RTC_SIZE 48
+
+typedef struct Save_File {
+  int fd;
+  uint8_t *map;
+  size_t map_size;
+  size_t ram_size;
+  bool has_rtc;
+
+  uint64_t dirty;      // pages written since the last flush
+  int flush_requested;
+
+  struct Save_File *next;
+} Save_File_t;
+
+// Maps <rom>.sav and points cart->ram at it. 0 on success; -1 leaves
+// cart->ram private, loaded from the .sav if another session has it.
+int save_open(Cartridge_t *cart, const char *rom_path);
+// Final flush, unmaps the file. cart->ram is gone afterwards.
+void save_close(Cartridge_t *cart);
+// Safe to call from the emulation thread: no file I/O
+void save_request_flush(Cartridge_t *cart);
+// Emulation thread, once per frame: updates the RTC footer in place
+void save_frame(Cartridge_t *cart);
+
+static inline void save_mark(Save_File_t *save, size_t off) {
+  __atomic_fetch_or(&save->dirty, 1ull << (off >> SAVE_PAGE_SHIFT), __ATOMIC_RELAXED);
+}
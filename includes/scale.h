@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  CPU upscalers for ARGB frames, used to fill Ppu_t::scaled_framebuffer
+  when there is no GPU to do it. Filters and the factors they support:
+
+    nearest   2-8x, pixel replication
+    scale2x   2x (Scale2x/EPX), 4x by running it twice
+    scale3x   3x (Scale3x/AdvMAME3x)
+    xbr       2x, xBR edge detection and blending. Colors compare by a
+              weighted YUV distance, except the "equal" tests, which are exact.
+
+  The kernels work on 4 pixels at a time with SSE2 or NEON. Scale3x and xBR
+  only fall back to per-pixel rules where some pixel in the group has an
+  edge; flat areas, most of a Game Boy frame, are written as plain
+  replication. Edge pixels repeat the frame border.
+
+  A scaler can run on its own thread: scaler_submit copies the source
+  frame and returns, scaler_wait blocks until the output is complete.
+*/
+
+typedef enum {
+  SCALE_NEAREST = 0,
+  SCALE_SCALE2X,
+  SCALE_SCALE3X,
+  SCALE_XBR,
+} Scale_Filter_t;
+
+typedef struct Scaler Scaler_t;
+
+// "nearest", "scale2x", "scale3x" or "xbr"; returns -1 if unknown
+int scale_filter_from_name(const char *name, Scale_Filter_t *out);
+// Factor used when the caller has no preference
+int scale_default_factor(Scale_Filter_t filter);
+bool scale_factor_supported(Scale_Filter_t filter, int factor);
+
+// Returns NULL if the factor is unsupported or the thread can't start
+Scaler_t *scaler_create(Scale_Filter_t filter, int factor, int width, int height, bool threaded);
+// dst holds (width * factor) * (height * factor) pixels and must stay
+// valid until scaler_wait. Waits for the previous frame first.
+void scaler_submit(Scaler_t *s, const uint32_t *src, uint32_t *dst);
+void scaler_wait(Scaler_t *s);
+void scaler_free(Scaler_t *s);
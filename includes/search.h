@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Cheat-style RAM search over WRAM (all 8 banks), HRAM or cartridge RAM.
+
+  search_begin() marks every offset as a candidate and snapshots the
+  region. Each search_step() keeps only the candidates whose current value
+  passes the test against the previous snapshot (or the operand), then
+  takes a new snapshot. Candidates are a bitset with one bit per byte
+  offset into the backing array; for WRAM offset / 0x1000 is the bank.
+
+  The kernels use AVX2 when the CPU has it, then SSE2, then plain C.
+*/
+
+typedef enum {
+  SEARCH_WRAM = 0,
+  SEARCH_HRAM,
+  SEARCH_CART_RAM,
+} search_region_t;
+
+typedef enum {
+  SEARCH_U8 = 0,
+  SEARCH_U16,  // little endian, may start at any offset
+  SEARCH_BCD8, // two packed decimal digits, 0-99
+} search_width_t;
+
+typedef enum {
+  SEARCH_EQ = 0,    // value == operand
+  SEARCH_CHANGED,
+  SEARCH_UNCHANGED,
+  SEARCH_INC,       // increased by any amount
+  SEARCH_DEC,
+  SEARCH_INC_BY,    // value == previous + operand
+  SEARCH_DEC_BY,    // value == previous - operand
+} search_op_t;
+
+typedef struct Ram_Search {
+  search_region_t region;
+  search_width_t width;
+  size_t size;
+  uint8_t *snapshot;
+  uint64_t *candidates;
+  size_t count;
+} Ram_Search_t;
+
+struct Bus;
+
+Ram_Search_t *search_begin(struct Bus *bus, search_region_t region, search_width_t width);
+// Narrows the candidate set, returns how many remain
+size_t search_step(Ram_Search_t *s, struct Bus *bus, search_op_t op, uint32_t operand);
+// Writes up to max candidate offsets, returns how many were written
+size_t search_results(const Ram_Search_t *s, uint32_t *offsets, size_t max);
+void search_free(Ram_Search_t *s);
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  gzip (.gz) and zip (.zip) ROM containers. The compressed file is
+  inflated straight into the final ROM buffer, which is sized from the
+  gzip ISIZE trailer or the zip central directory up front and padded to
+  whole 16KB banks with 0xFF, so no temp files or intermediate copies
+  are needed. Only DEFLATE and stored members are supported. From a zip
+  the first .gb/.gbc/.sgb entry is used, or the first entry if none match.
+*/
+
+// Only looks at the magic, the first 4 bytes are enough
+bool unpack_is_compressed(const uint8_t *data, size_t len);
+// Returns a malloc'd buffer of *padded bytes holding *size bytes of ROM,
+// or NULL if the container is broken or unsupported.
+uint8_t *unpack_rom(const uint8_t *data, size_t len, size_t *size, size_t *padded);
@@ -124,8 +124,19 @@ void dump_memory_range(const Bus_t *bus, uint16_t start, uint16_t end, const cha
     return;
   }
 
-  for (uint16_t addr = start; addr <= end; addr++) {
-    buffer[addr - start] = read_byte_bus((Bus_t *)bus, addr);
+  // copy whole spans of plain memory, decode only I/O and unmapped bytes
+  size_t i = 0;
+  while (i < size) {
+    uint16_t addr = (uint16_t)(start + i);
+    uint16_t span = 0;
+    const uint8_t *src = bus_host_ptr((Bus_t *)bus, addr, &span);
+    if (!src) {
+      buffer[i++] = read_byte_bus((Bus_t *)bus, addr);
+      continue;
+    }
+    if (span > size - i) span = (uint16_t)(size - i);
+    memcpy(buffer + i, src, span);
+    i += span;
   }
 
   int result = write_binary_file(buffer, size, filename);
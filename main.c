@@ -1,16 +1,42 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "cpu.h"
 #include "ppu.h"
 #include "memory.h"
+#include "memprof.h"
+#include "cheats.h"
+#include "library.h"
+#include "scale.h"
 #include <SDL2/SDL.h>
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    fprintf(stderr, "Usage: %s rom.gb [bootrom.bin]\n", argv[0]);
+    fprintf(stderr, "Usage: %s rom.gb [bootrom.bin] [--cheat CODE]... [--rtc-sync] [--lcd-colors] [--accurate]\n"
+                    "       [--frame-skip N] [--scaler nearest|scale2x|scale3x|xbr] [--render-thread]\n"
+                    "       %s --library DIR\n", argv[0], argv[0]);
     return 1;
   }
 
+  // --library DIR: refresh DIR/romlib.idx and list it
+  if (strcmp(argv[1], "--library") == 0) {
+    if (argc < 3) return 1;
+    char index[4096];
+    snprintf(index, sizeof(index), "%s/" LIBRARY_INDEX_NAME, argv[2]);
+    Rom_Library_t *lib = library_open(index);
+    if (!lib) return 1;
+    int scanned = library_scan(lib, argv[2], 0);
+    if (scanned >= 0 && lib->changed) library_save(lib);
+    for (size_t i = 0; i < lib->count; i++) {
+      const Rom_Entry_t *e = &lib->entries[i];
+      printf("%016llx %-16s %s%s %s\n", (unsigned long long)e->hash, e->title,
+             e->is_cgb ? "CGB" : "DMG", e->header_ok ? "" : " (bad header)", e->path);
+    }
+    fprintf(stderr, "[LIB] %zu ROMs, %d rescanned\n", lib->count, scanned < 0 ? 0 : scanned);
+    library_free(lib);
+    return scanned < 0;
+  }
+
   Bus_t *bus = malloc(sizeof(Bus_t));
   init_bus(bus);
 
@@ -21,8 +47,48 @@ int main(int argc, char *argv[]) {
     fprintf(stderr, "[ROM] failed to load '%s'\n", argv[1]);
   }
 
+  bool lcd_colors = false;
+  bool accurate = false;
+  bool render_thread = false;
+  int render_every = 1;
+  bool use_scaler = false;
+  Scale_Filter_t filter = SCALE_NEAREST;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--cheat") == 0 && i + 1 < argc)
+      cheat_add(bus, argv[++i]);
+    else if (strcmp(argv[i], "--rtc-sync") == 0)
+      cart_rtc_sync_wallclock(bus->cartridge);
+    else if (strcmp(argv[i], "--lcd-colors") == 0)
+      lcd_colors = true;
+    else if (strcmp(argv[i], "--accurate") == 0)
+      accurate = true;
+    else if (strcmp(argv[i], "--render-thread") == 0)
+      render_thread = true;
+    else if (strcmp(argv[i], "--frame-skip") == 0 && i + 1 < argc)
+      render_every = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--scaler") == 0 && i + 1 < argc) {
+      if (scale_filter_from_name(argv[++i], &filter) == 0)
+        use_scaler = true;
+      else
+        fprintf(stderr, "[SCALE] unknown scaler '%s'\n", argv[i]);
+    }
+  }
+
+  // with --scaler the CPU fills scaled_framebuffer on a worker thread,
+  // otherwise SDL scales the plain framebuffer
+  int out_scale = use_scaler ? scale_default_factor(filter) : 1;
   Ppu_t *ppu = malloc(sizeof(Ppu_t));
-  start_display(ppu, bus, 4);
+  start_display(ppu, bus, out_scale);
+  Scaler_t *scaler = NULL;
+  if (use_scaler) {
+    scaler = scaler_create(filter, out_scale, GB_WIDTH, GB_HEIGHT, true);
+    if (!scaler) out_scale = 1;
+  }
+  if (lcd_colors) ppu_set_color_correction(ppu, true);
+  ppu->accurate = accurate;
+  ppu_set_frame_skip(ppu, render_every);
+  // falls back to drawing inline if it can't start
+  if (render_thread) ppu_start_render_thread(ppu);
 
   bus->ppu = ppu;
 
@@ -66,7 +132,8 @@ int main(int argc, char *argv[]) {
                                      GB_HEIGHT * scale, 0);
   SDL_Renderer *ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED);
   SDL_Texture *tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888,
-                        SDL_TEXTUREACCESS_STREAMING, GB_WIDTH, GB_HEIGHT);
+                        SDL_TEXTUREACCESS_STREAMING, GB_WIDTH * out_scale,
+                        GB_HEIGHT * out_scale);
 
   bool running = true;
 
@@ -81,8 +148,16 @@ int main(int argc, char *argv[]) {
       helper(&cpu);
     }
     
-    SDL_UpdateTexture(tex, NULL, ppu->framebuffer,
-                      GB_WIDTH * sizeof(uint32_t));
+    const uint32_t *frame = (const uint32_t*)ppu_acquire_frame(ppu, NULL);
+    if (scaler) {
+      // shows the previous frame, scaled while this one was emulated
+      scaler_wait(scaler);
+      SDL_UpdateTexture(tex, NULL, ppu->scaled_framebuffer,
+                        GB_WIDTH * out_scale * sizeof(uint32_t));
+      scaler_submit(scaler, frame, ppu->scaled_framebuffer);
+    } else {
+      SDL_UpdateTexture(tex, NULL, frame, GB_WIDTH * sizeof(uint32_t));
+    }
     
     ppu->frame_ready = false;
     
@@ -172,6 +247,16 @@ int main(int argc, char *argv[]) {
     last_frame_time = now;
     }
 
+#ifdef PROFILE_MEM
+    memprof_write_heatmap(bus, "heatmap.csv");
+    memprof_summary(bus, stderr, 32);
+    memprof_free(bus);
+#endif
+
+    ppu_stop_render_thread(ppu);
+    scaler_free(scaler);
+    free_cart(bus->cartridge);
+
     SDL_DestroyTexture(tex);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
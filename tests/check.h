@@ -0,0 +1,27 @@
+#pragma once
+#include <stdio.h>
+
+/*
+  Minimal helpers for the self-checks under tests/, built and run by
+  `make check`. Each check is its own program and exits non-zero when
+  anything failed, printing one [CHECK] line per failure.
+*/
+
+static int check_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+      fprintf(stderr, "[CHECK] %s:%d: ", __FILE__, __LINE__); \
+      fprintf(stderr, __VA_ARGS__); \
+      fputc('\n', stderr); \
+      check_failures++; \
+    } \
+  } while (0)
+
+static inline int check_done(const char *name) {
+  if (check_failures)
+    fprintf(stderr, "[CHECK] %s: %d failure(s)\n", name, check_failures);
+  else
+    printf("%s: ok\n", name);
+  return check_failures ? 1 : 0;
+}
@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <string.h>
+#include "compose.h"
+#include "check.h"
+
+// from compose_scalar.c and compose_sse2.c, the same compositing built
+// with fewer kernels; the plain names pick AVX2 when this CPU has it
+void scalar_compose_line(const Ppu_Line_t *line, bool cgb, bool bg_master,
+                         const uint32_t *colors, uint32_t *out);
+void scalar_compose_line_slots(const Ppu_Line_t *line, bool cgb, bool bg_master, uint8_t *slots);
+void sse2_compose_line(const Ppu_Line_t *line, bool cgb, bool bg_master,
+                       const uint32_t *colors, uint32_t *out);
+void sse2_compose_line_slots(const Ppu_Line_t *line, bool cgb, bool bg_master, uint8_t *slots);
+
+typedef struct {
+  const char *name;
+  void (*argb)(const Ppu_Line_t *line, bool cgb, bool bg_master,
+               const uint32_t *colors, uint32_t *out);
+  void (*slots)(const Ppu_Line_t *line, bool cgb, bool bg_master, uint8_t *slots);
+} Compose_Impl_t;
+
+static const Compose_Impl_t impls[] = {
+  { "scalar", scalar_compose_line, scalar_compose_line_slots },
+  { "sse2", sse2_compose_line, sse2_compose_line_slots },
+  { "best", compose_line, compose_line_slots },
+};
+#define IMPLS (sizeof(impls) / sizeof(impls[0]))
+
+static uint32_t rng = 0x2545F491u;
+static uint32_t next_rand(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// 0: anything goes, 1: no sprites, 2: sprites everywhere, 3: BG color 0
+// only, so the priority bits decide every pixel
+static void fill_line(Ppu_Line_t *line, int kind) {
+  for (int x = 0; x < 160; x++) {
+    uint32_t r = next_rand();
+    line->bg_id[x] = (kind == 3) ? 0 : (uint8_t)(r & 3);
+    line->bg_attr[x] = (uint8_t)(r >> 8);
+    line->obj_id[x] = (kind == 1) ? 0 : (kind == 2) ? (uint8_t)(1 + (r >> 16) % 3) : (uint8_t)((r >> 16) & 3);
+    line->obj_attr[x] = (uint8_t)(r >> 24);
+  }
+}
+
+int main(void) {
+  Ppu_Line_t line;
+  uint32_t colors[128];
+  uint32_t want[160], got[160];
+  uint8_t want_slots[160], got_slots[160];
+
+  for (int round = 0; round < 2000; round++) {
+    for (int i = 0; i < 128; i++) colors[i] = next_rand();
+    fill_line(&line, round % 4);
+    for (int mode = 0; mode < 4; mode++) {
+      bool cgb = mode & 1, bg_master = mode & 2;
+      impls[0].argb(&line, cgb, bg_master, colors, want);
+      impls[0].slots(&line, cgb, bg_master, want_slots);
+      for (size_t k = 1; k < IMPLS; k++) {
+        impls[k].argb(&line, cgb, bg_master, colors, got);
+        impls[k].slots(&line, cgb, bg_master, got_slots);
+        int x = 0;
+        while (x < 160 && got[x] == want[x]) x++;
+        CHECK(x == 160, "%s round %d cgb %d bg_master %d: pixel %d is %08x, scalar %08x",
+              impls[k].name, round, cgb, bg_master, x, x < 160 ? got[x] : 0, x < 160 ? want[x] : 0);
+        x = 0;
+        while (x < 160 && got_slots[x] == want_slots[x]) x++;
+        CHECK(x == 160, "%s round %d cgb %d bg_master %d: slot %d is %u, scalar %u",
+              impls[k].name, round, cgb, bg_master, x, x < 160 ? got_slots[x] : 0,
+              x < 160 ? want_slots[x] : 0);
+      }
+    }
+  }
+  return check_done("compose");
+}
@@ -0,0 +1,154 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "ppu_scene.h"
+
+/*
+  Output formats: the same scripted scene is drawn once per format, and
+  every non-ARGB frame must equal the ARGB frame run through the
+  conversion below. Covers the line renderer and the FIFO backend.
+*/
+
+#define FRAMES 4
+#define ARGB_SIZE (GB_WIDTH * GB_HEIGHT * 4)
+
+static const char *format_names[] = { "argb8888", "indexed", "rgb565", "gray8", "gray_small" };
+
+// Mid-frame scroll, LCDC bit 0 and, on DMG, BGP writes; BGP only moves
+// DMG shades, so indexed output stays comparable against one palette
+static void hblank(Scene_t *s, int ly, void *arg) {
+  (void)arg;
+  if (ly % 16 == 7) scene_write(s, 0xFF43, (uint8_t)(s->ppu->SCX + ly));
+  if (ly % 48 == 30) scene_write(s, 0xFF40, s->ppu->LCDC ^ 0x01);
+  if (ly % 32 == 20 && !s->bus->is_cgb) scene_write(s, 0xFF47, (uint8_t)(s->ppu->BGP * 5 + 1));
+}
+
+// Between frames, so CGB palettes change too
+static void next_frame(Scene_t *s, int frame) {
+  scene_write(s, 0xFF42, (uint8_t)(s->ppu->SCY + 9));
+  if (!s->bus->is_cgb) return;
+  scene_write(s, 0xFF68, (uint8_t)(0x80 | (frame * 12)));
+  for (int i = 0; i < 8; i++) scene_write(s, 0xFF69, (uint8_t)(frame * 37 + i * 11));
+}
+
+// Draws FRAMES frames in format, copying out each one
+static void run_scene(bool cgb, bool accurate, Ppu_Format_t format, uint8_t *out,
+                      uint32_t (*palettes)[128]) {
+  Scene_t s;
+  size_t size = ppu_output_size(format);
+  scene_seed = cgb ? 0x1234567u : 0x7654321u;
+  scene_open(&s, cgb);
+  s.ppu->accurate = accurate;
+  ppu_set_format(s.ppu, format);
+  scene_fill(&s);
+  for (int f = 0; f < FRAMES; f++) {
+    next_frame(&s, f);
+    memcpy(out + f * size, scene_frame(&s, hblank, NULL), size);
+    int count;
+    const uint32_t *pal = ppu_output_palette(s.ppu, &count);
+    memcpy(palettes[f], pal, count * sizeof(uint32_t));
+  }
+  scene_close(&s);
+}
+
+static uint8_t luma(uint32_t c) {
+  uint32_t r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+  return (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+}
+
+// Box filter spans for GRAY_SMALL: [lo, hi) of 'full' source pixels
+// feeding output pixel i of PPU_GRAY_SMALL_SIZE
+static void small_span(int i, int full, int *lo, int *hi) {
+  const int n = PPU_GRAY_SMALL_SIZE;
+  *lo = (i * full + n - 1) / n;
+  *hi = ((i + 1) * full + n - 1) / n;
+}
+
+static void check_spans(void) {
+  for (int axis = 0; axis < 2; axis++) {
+    int full = axis ? GB_HEIGHT : GB_WIDTH, next = 0;
+    for (int i = 0; i < PPU_GRAY_SMALL_SIZE; i++) {
+      int lo, hi;
+      small_span(i, full, &lo, &hi);
+      CHECK(lo == next && hi > lo && hi - lo <= 2, "gray_small %s span %d is [%d, %d)",
+            axis ? "row" : "column", i, lo, hi);
+      next = hi;
+    }
+    CHECK(next == full, "gray_small %s spans end at %d", axis ? "row" : "column", next);
+  }
+}
+
+// Expected value of byte/pixel i of a frame in format, from the ARGB frame
+static uint32_t convert(const uint32_t *argb, Ppu_Format_t format, size_t i) {
+  uint32_t c = argb[i];
+  switch (format) {
+    case PPU_FORMAT_RGB565:
+      return ((c >> 19) & 0x1F) << 11 | ((c >> 10) & 0x3F) << 5 | ((c >> 3) & 0x1F);
+    case PPU_FORMAT_GRAY8:
+      return luma(c);
+    case PPU_FORMAT_GRAY_SMALL: {
+      int x0, x1, y0, y1;
+      small_span((int)(i % PPU_GRAY_SMALL_SIZE), GB_WIDTH, &x0, &x1);
+      small_span((int)(i / PPU_GRAY_SMALL_SIZE), GB_HEIGHT, &y0, &y1);
+      int sum = 0, count = (x1 - x0) * (y1 - y0);
+      for (int y = y0; y < y1; y++)
+        for (int x = x0; x < x1; x++) sum += luma(argb[y * GB_WIDTH + x]);
+      return (uint32_t)((sum + count / 2) / count);
+    }
+    default:
+      return c;
+  }
+}
+
+static void check_format(bool cgb, bool accurate, Ppu_Format_t format, const uint8_t *argb) {
+  size_t size = ppu_output_size(format);
+  size_t pixels = format == PPU_FORMAT_GRAY_SMALL ? size : (size_t)GB_WIDTH * GB_HEIGHT;
+  uint8_t *out = (uint8_t*)malloc(FRAMES * size);
+  uint32_t palettes[FRAMES][128];
+  run_scene(cgb, accurate, format, out, palettes);
+
+  // the first frame of a fresh PPU doesn't draw line 0
+  for (int f = 1; f < FRAMES; f++) {
+    const uint32_t *want = (const uint32_t*)(argb + f * ARGB_SIZE);
+    const uint8_t *got = out + f * size;
+    size_t bad = pixels;
+    uint32_t g = 0, w = 0;
+    for (size_t i = 0; i < pixels && bad == pixels; i++) {
+      switch (format) {
+        case PPU_FORMAT_INDEXED:
+          // the pixel's color is its entry in ppu_output_palette
+          g = 0xFF000000u | palettes[f][got[i]];
+          w = want[i] | 0xFF000000u;
+          break;
+        case PPU_FORMAT_RGB565:
+          g = ((const uint16_t*)got)[i];
+          w = convert(want, format, i);
+          break;
+        default:
+          g = got[i];
+          w = convert(want, format, i);
+          break;
+      }
+      if (g != w) bad = i;
+    }
+    CHECK(bad == pixels, "%s%s %s frame %d: pixel %zu is %x, want %x", cgb ? "cgb" : "dmg",
+          accurate ? " accurate" : "", format_names[format], f, bad, g, w);
+  }
+  free(out);
+}
+
+int main(void) {
+  check_spans();
+  uint8_t *argb = (uint8_t*)malloc(FRAMES * ARGB_SIZE);
+  uint32_t palettes[FRAMES][128];
+  for (int cgb = 0; cgb <= 1; cgb++) {
+    for (int accurate = 0; accurate <= 1; accurate++) {
+      run_scene(cgb, accurate, PPU_FORMAT_ARGB8888, argb, palettes);
+      for (int format = PPU_FORMAT_INDEXED; format <= PPU_FORMAT_GRAY_SMALL; format++)
+        check_format(cgb, accurate, (Ppu_Format_t)format, argb);
+    }
+  }
+  free(argb);
+  return check_done("formats");
+}
@@ -0,0 +1,178 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "ppu_scene.h"
+
+/*
+  Line reuse: after each change to a line's inputs, the next three frames
+  (one per frame buffer, each holding signatures from before the change)
+  must match a fresh PPU drawing the same state from scratch.
+*/
+
+static uint16_t bg_map_entry(const Ppu_t *p) {
+  uint16_t map = (p->LCDC & 0x08) ? 0x9C00 : 0x9800;
+  return (uint16_t)(map + ((p->SCY >> 3) & 31) * 32 + ((p->SCX >> 3) & 31));
+}
+
+static void invert_tile(Scene_t *s, uint16_t addr) {
+  for (int bank = 0; bank <= (int)s->bus->is_cgb; bank++) {
+    scene_write(s, 0xFF4F, (uint8_t)bank);
+    for (int i = 0; i < 16; i++)
+      scene_write(s, (uint16_t)(addr + i), (uint8_t)~s->bus->vram[bank * 0x2000 + addr - 0x8000 + i]);
+  }
+  scene_write(s, 0xFF4F, 0);
+}
+
+static void change_bg_tile(Scene_t *s) {
+  uint8_t tile = s->bus->vram[bg_map_entry(s->ppu) - 0x8000];
+  uint16_t addr = (s->ppu->LCDC & 0x10) ? (uint16_t)(0x8000 + tile * 16)
+                                        : (uint16_t)(0x9000 + (int8_t)tile * 16);
+  invert_tile(s, addr);
+}
+
+static void change_bg_map(Scene_t *s) {
+  uint16_t a = bg_map_entry(s->ppu);
+  scene_write(s, a, (uint8_t)(s->bus->vram[a - 0x8000] + 1));
+}
+
+static void change_bg_attr(Scene_t *s) {
+  uint16_t a = bg_map_entry(s->ppu);
+  scene_write(s, 0xFF4F, 1);
+  scene_write(s, a, (uint8_t)(s->bus->vram[0x2000 + a - 0x8000] ^ 0x07));
+  scene_write(s, 0xFF4F, 0);
+}
+
+static void change_bg_palette(Scene_t *s) {
+  scene_write(s, 0xFF47, (uint8_t)~s->ppu->BGP);
+  scene_write(s, 0xFF68, 0x80);
+  for (int i = 0; i < 64; i++) scene_write(s, 0xFF69, (uint8_t)scene_rand());
+}
+
+static void change_obj_palette(Scene_t *s) {
+  scene_write(s, 0xFF48, (uint8_t)~s->ppu->OBP0);
+  scene_write(s, 0xFF49, (uint8_t)~s->ppu->OBP1);
+  scene_write(s, 0xFF6A, 0x80);
+  for (int i = 0; i < 64; i++) scene_write(s, 0xFF6B, (uint8_t)scene_rand());
+}
+
+static void change_scx(Scene_t *s) { scene_write(s, 0xFF43, (uint8_t)(s->ppu->SCX + 3)); }
+static void change_scy(Scene_t *s) { scene_write(s, 0xFF42, (uint8_t)(s->ppu->SCY + 5)); }
+
+static void change_window_pos(Scene_t *s) {
+  scene_write(s, 0xFF4A, (uint8_t)(s->ppu->WY - 8));
+  scene_write(s, 0xFF4B, (uint8_t)(s->ppu->WX - 8));
+}
+
+static void change_window_map(Scene_t *s) {
+  uint16_t map = (s->ppu->LCDC & 0x40) ? 0x9C00 : 0x9800;
+  for (int i = 0; i < 4; i++)
+    scene_write(s, (uint16_t)(map + i), (uint8_t)(s->bus->vram[map - 0x8000 + i] + 1));
+}
+
+static void toggle_lcdc(Scene_t *s, uint8_t bit) { scene_write(s, 0xFF40, s->ppu->LCDC ^ bit); }
+static void toggle_window(Scene_t *s) { toggle_lcdc(s, 0x20); }
+static void toggle_tile_data(Scene_t *s) { toggle_lcdc(s, 0x10); }
+static void toggle_bg_map(Scene_t *s) { toggle_lcdc(s, 0x08); }
+static void toggle_sprite_size(Scene_t *s) { toggle_lcdc(s, 0x04); }
+static void toggle_sprites(Scene_t *s) { toggle_lcdc(s, 0x02); }
+
+static void move_sprite(Scene_t *s) {
+  scene_write(s, 0xFE00, 40);
+  scene_write(s, 0xFE01, (uint8_t)(s->bus->oam[1] + 5));
+}
+
+static void change_sprite_tile(Scene_t *s) { scene_write(s, 0xFE02, (uint8_t)(s->bus->oam[2] + 1)); }
+
+static void change_sprite_tile_data(Scene_t *s) {
+  uint8_t tile = s->bus->oam[2] & ((s->ppu->LCDC & 0x04) ? 0xFE : 0xFF);
+  invert_tile(s, (uint16_t)(0x8000 + tile * 16));
+}
+
+typedef struct {
+  const char *name;
+  void (*apply)(Scene_t *s);
+  bool cgb_only;
+} Change_t;
+
+// Toggles come back around later in the list, so rows whose buffer
+// still holds the matching old signature are covered too
+static const Change_t changes[] = {
+  { "bg tile data", change_bg_tile, false },
+  { "bg map entry", change_bg_map, false },
+  { "bg map attributes", change_bg_attr, true },
+  { "bg palette", change_bg_palette, false },
+  { "obj palette", change_obj_palette, false },
+  { "scx", change_scx, false },
+  { "scy", change_scy, false },
+  { "window position", change_window_pos, false },
+  { "window map row", change_window_map, false },
+  { "window off", toggle_window, false },
+  { "window on", toggle_window, false },
+  { "tile data select", toggle_tile_data, false },
+  { "bg map select", toggle_bg_map, false },
+  { "sprite position", move_sprite, false },
+  { "sprite tile", change_sprite_tile, false },
+  { "sprite tile data", change_sprite_tile_data, false },
+  { "sprite size", toggle_sprite_size, false },
+  { "sprites off", toggle_sprites, false },
+  { "sprites on", toggle_sprites, false },
+  { "tile data select back", toggle_tile_data, false },
+  { "bg palette again", change_bg_palette, false },
+};
+
+static const char *format_names[] = { "argb8888", "indexed", "rgb565", "gray8", "gray_small" };
+
+static void check_scene(bool cgb, Ppu_Format_t format) {
+  Scene_t s, ref;
+  size_t size = ppu_output_size(format);
+  uint8_t *before = (uint8_t*)malloc(size);
+  uint32_t before_colors[128];
+
+  scene_open(&s, cgb);
+  ppu_set_format(s.ppu, format);
+  scene_fill(&s);
+  // one frame per buffer to fill in the signatures, then a steady one
+  for (int f = 0; f < PPU_FRAME_BUFFERS + 1; f++) scene_frame(&s, NULL, NULL);
+  const void *frame = scene_frame(&s, NULL, NULL);
+  CHECK(s.ppu->frame_lines_reused == GB_HEIGHT, "%s %s: steady frame reused %u lines",
+        cgb ? "cgb" : "dmg", format_names[format], s.ppu->frame_lines_reused);
+
+  for (size_t c = 0; c < sizeof(changes) / sizeof(changes[0]); c++) {
+    const Change_t *ch = &changes[c];
+    if (ch->cgb_only && !cgb) continue;
+    memcpy(before, frame, size);
+    int colors;
+    memcpy(before_colors, ppu_output_palette(s.ppu, &colors), colors * sizeof(uint32_t));
+    ch->apply(&s);
+
+    scene_reference(&ref, &s);
+    const void *want = scene_frame(&ref, NULL, NULL);
+    // INDEXED on CGB holds palette slots, palette changes show in the colors
+    bool visible = memcmp(want, before, size) != 0 ||
+                   (format == PPU_FORMAT_INDEXED &&
+                    memcmp(ppu_output_palette(ref.ppu, &colors), before_colors,
+                           colors * sizeof(uint32_t)) != 0);
+    CHECK(visible, "%s %s %s: change is not visible",
+          cgb ? "cgb" : "dmg", format_names[format], ch->name);
+
+    for (int f = 0; f < PPU_FRAME_BUFFERS; f++) {
+      frame = scene_frame(&s, NULL, NULL);
+      size_t i = 0;
+      while (i < size && ((const uint8_t*)frame)[i] == ((const uint8_t*)want)[i]) i++;
+      CHECK(i == size, "%s %s %s frame %d: stale output from byte %zu (line %zu)",
+            cgb ? "cgb" : "dmg", format_names[format], ch->name, f, i,
+            format == PPU_FORMAT_GRAY_SMALL ? i / PPU_GRAY_SMALL_SIZE : i * GB_HEIGHT / size);
+    }
+    scene_close(&ref);
+  }
+  scene_close(&s);
+  free(before);
+}
+
+int main(void) {
+  for (int cgb = 0; cgb <= 1; cgb++)
+    for (int format = PPU_FORMAT_ARGB8888; format <= PPU_FORMAT_GRAY_SMALL; format++)
+      check_scene(cgb, (Ppu_Format_t)format);
+  return check_done("line signatures");
+}
@@ -0,0 +1,149 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "ppu_scene.h"
+
+/*
+  Render thread: one scripted run of VRAM, OAM, palette, LCDC and scroll
+  writes, drawn inline and again with the render thread, must give the
+  same frames. The threaded run starts the thread on a VBlank after a few
+  inline frames, stops it mid-frame and starts it again mid-frame, and
+  overflows the VRAM journal with the LCD on and with it off. `make
+  check-tsan` builds this under ThreadSanitizer.
+
+  Frames 0-7 are quiet apart from SCX moving away and back while the
+  thread runs, so the inline frames after the stop see inputs that match
+  signatures from before the thread started.
+*/
+
+#define FRAMES 16
+#define START_FRAME 3   // thread started in the VBlank after this frame
+#define STOP_FRAME 5    // stopped on line 70
+#define RESTART_FRAME 8 // started again on line 100, script runs from here
+#define BURST 24576     // VRAM writes in one go, past the 16K journal
+
+typedef struct {
+  int frame;
+  bool threaded;
+} Script_t;
+
+// Every VRAM byte once, then the rest on the 9C00 map, so the entries a
+// lapped journal would lose are never written again
+static void vram_burst(Scene_t *s) {
+  int banks = s->bus->is_cgb ? 2 : 1;
+  for (int i = 0; i < BURST; i++) {
+    if (i < banks * 0x2000) {
+      if ((i & 0x1FFF) == 0) scene_write(s, 0xFF4F, (uint8_t)(i >> 13));
+      scene_write(s, (uint16_t)(0x8000 + (i & 0x1FFF)), (uint8_t)scene_rand());
+    } else {
+      scene_write(s, (uint16_t)(0x9C00 + (i & 0x3FF)), (uint8_t)scene_rand());
+    }
+  }
+  scene_write(s, 0xFF4F, 0);
+}
+
+static void hblank(Scene_t *s, int ly, void *arg) {
+  Script_t *sc = (Script_t*)arg;
+  if (sc->threaded && sc->frame == STOP_FRAME && ly == 70) ppu_stop_render_thread(s->ppu);
+  if (sc->threaded && sc->frame == RESTART_FRAME && ly == 100)
+    CHECK(ppu_start_render_thread(s->ppu) == 0, "restarting the render thread failed");
+  if (sc->frame < RESTART_FRAME) return;
+
+  uint32_t r = scene_rand();
+  switch (ly % 8) {
+    case 0: {
+      if (s->bus->is_cgb) scene_write(s, 0xFF4F, (uint8_t)(r & 1));
+      uint16_t a = (uint16_t)(0x8000 + (r >> 8) % 0x1FF0);
+      for (int i = 0; i < 16; i++) scene_write(s, (uint16_t)(a + i), (uint8_t)scene_rand());
+      scene_write(s, 0xFF4F, 0);
+      break;
+    }
+    case 1: {
+      uint16_t a = (uint16_t)(0xFE00 + ((r >> 8) % 40) * 4);
+      scene_write(s, a, (uint8_t)(16 + scene_rand() % 144));
+      scene_write(s, (uint16_t)(a + 1), (uint8_t)(8 + scene_rand() % 160));
+      scene_write(s, (uint16_t)(a + 2), (uint8_t)scene_rand());
+      scene_write(s, (uint16_t)(a + 3), (uint8_t)scene_rand());
+      break;
+    }
+    case 2:
+      if (s->bus->is_cgb) {
+        scene_write(s, (r & 0x100) ? 0xFF6A : 0xFF68, (uint8_t)(0x80 | ((r >> 9) & 0x3F)));
+        for (int i = 0; i < 4; i++) scene_write(s, (r & 0x100) ? 0xFF6B : 0xFF69, (uint8_t)scene_rand());
+      } else {
+        scene_write(s, (uint16_t)(0xFF47 + (r >> 8) % 3), (uint8_t)(r >> 16));
+      }
+      break;
+    case 3: {
+      static const uint8_t bits[] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40 };
+      scene_write(s, 0xFF40, s->ppu->LCDC ^ bits[(r >> 8) % 7]);
+      break;
+    }
+    case 4:
+      scene_write(s, (uint16_t)(0xFF42 + (r >> 8) % 2), (uint8_t)(r >> 16));
+      scene_write(s, (uint16_t)(0xFF4A + (r >> 9) % 2), (uint8_t)((r >> 24) % 168));
+      break;
+    default:
+      break;
+  }
+}
+
+// Between frames: the thread start and the SCX excursion, then a burst
+// that fills the journal while the LCD is on and later one with it off
+static void vblank(Scene_t *s, Script_t *sc) {
+  int frame = sc->frame;
+  if (frame == START_FRAME) {
+    if (sc->threaded) CHECK(ppu_start_render_thread(s->ppu) == 0, "starting the render thread failed");
+    scene_write(s, 0xFF43, (uint8_t)(s->ppu->SCX + 8));
+  }
+  if (frame == START_FRAME + 1) scene_write(s, 0xFF43, (uint8_t)(s->ppu->SCX - 8));
+  if (frame == 9) vram_burst(s);
+  if (frame == 12) {
+    scene_write(s, 0xFF40, s->ppu->LCDC & 0x7F);
+    vram_burst(s);
+    scene_write(s, 0xFF40, s->ppu->LCDC | 0x80);
+  }
+}
+
+static void run(bool cgb, Ppu_Format_t format, bool threaded, uint8_t *out) {
+  Scene_t s;
+  Script_t sc = { 0, threaded };
+  size_t size = ppu_output_size(format);
+  scene_seed = cgb ? 0x5EED0001u : 0x5EED0002u;
+  scene_open(&s, cgb);
+  ppu_set_format(s.ppu, format);
+  scene_fill(&s);
+
+  for (sc.frame = 0; sc.frame < FRAMES; sc.frame++) {
+    memcpy(out + sc.frame * size, scene_frame(&s, hblank, &sc), size);
+    vblank(&s, &sc);
+    bool running = (sc.frame >= START_FRAME && sc.frame < STOP_FRAME) || sc.frame >= RESTART_FRAME;
+    CHECK((s.ppu->render != NULL) == (threaded && running),
+          "render thread state after frame %d", sc.frame);
+  }
+  scene_close(&s);
+}
+
+int main(void) {
+  static const Ppu_Format_t formats[] = { PPU_FORMAT_ARGB8888, PPU_FORMAT_GRAY_SMALL };
+  for (int cgb = 0; cgb <= 1; cgb++) {
+    for (size_t fi = 0; fi < sizeof(formats) / sizeof(formats[0]); fi++) {
+      size_t size = ppu_output_size(formats[fi]);
+      uint8_t *inline_frames = (uint8_t*)malloc(FRAMES * size);
+      uint8_t *thread_frames = (uint8_t*)malloc(FRAMES * size);
+      run(cgb, formats[fi], false, inline_frames);
+      run(cgb, formats[fi], true, thread_frames);
+      for (int f = 0; f < FRAMES; f++) {
+        const uint8_t *a = inline_frames + f * size, *b = thread_frames + f * size;
+        size_t i = 0;
+        while (i < size && a[i] == b[i]) i++;
+        CHECK(i == size, "%s format %d frame %d: threaded output differs from byte %zu",
+              cgb ? "cgb" : "dmg", (int)formats[fi], f, i);
+      }
+      free(inline_frames);
+      free(thread_frames);
+    }
+  }
+  return check_done("render thread");
+}
@@ -0,0 +1,86 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "scale.h"
+#include "check.h"
+
+// from scale_scalar.c, the same scalers built without SSE2/NEON
+Scaler_t *scalar_scaler_create(Scale_Filter_t filter, int factor, int width, int height, bool threaded);
+void scalar_scaler_submit(Scaler_t *s, const uint32_t *src, uint32_t *dst);
+void scalar_scaler_free(Scaler_t *s);
+
+static uint32_t rng = 0x12345678u;
+static uint32_t next_rand(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// 0: four-shade Game Boy palette, so the exact-equality rules fire a lot
+// 1: any color, so the YUV distances and blends get exercised
+// 2: flat areas with a few boxes, the path the group shortcuts take
+static void fill_frame(uint32_t *px, int w, int h, int kind) {
+  static const uint32_t shades[4] = { 0xFFE0F8D0, 0xFF88C070, 0xFF346856, 0xFF081820 };
+  for (int i = 0; i < w * h; i++) {
+    uint32_t r = next_rand();
+    px[i] = kind == 0 ? shades[r & 3] : kind == 1 ? (r | 0xFF000000u) : shades[0];
+  }
+  if (kind != 2) return;
+  for (int n = 0; n < 12; n++) {
+    int x0 = (int)(next_rand() % (unsigned)w), y0 = (int)(next_rand() % (unsigned)h);
+    int bw = 1 + (int)(next_rand() % 9), bh = 1 + (int)(next_rand() % 9);
+    uint32_t c = shades[1 + next_rand() % 3];
+    for (int y = y0; y < h && y < y0 + bh; y++)
+      for (int x = x0; x < w && x < x0 + bw; x++) px[y * w + x] = c;
+  }
+}
+
+static const char *filter_names[] = { "nearest", "scale2x", "scale3x", "xbr" };
+
+static void check_one(Scale_Filter_t filter, int factor, int w, int h, bool threaded) {
+  size_t out = (size_t)w * factor * h * factor;
+  uint32_t *src = (uint32_t*)malloc((size_t)w * h * 4);
+  uint32_t *simd = (uint32_t*)malloc(out * 4);
+  uint32_t *ref = (uint32_t*)malloc(out * 4);
+  Scaler_t *a = scaler_create(filter, factor, w, h, threaded);
+  Scaler_t *b = scalar_scaler_create(filter, factor, w, h, false);
+  CHECK(a && b, "%s %dx: scaler_create failed", filter_names[filter], factor);
+
+  for (int kind = 0; a && b && kind < 3; kind++) {
+    fill_frame(src, w, h, kind);
+    memset(simd, 0, out * 4);
+    memset(ref, 0, out * 4);
+    scaler_submit(a, src, simd);
+    scaler_wait(a);
+    scalar_scaler_submit(b, src, ref);
+
+    size_t i = 0;
+    while (i < out && simd[i] == ref[i]) i++;
+    CHECK(i == out, "%s %dx %dx%d frame %d%s: pixel (%zu, %zu) is %08x, scalar %08x",
+          filter_names[filter], factor, w, h, kind, threaded ? " threaded" : "",
+          i % ((size_t)w * factor), i / ((size_t)w * factor),
+          i < out ? simd[i] : 0, i < out ? ref[i] : 0);
+  }
+  scaler_free(a);
+  scalar_scaler_free(b);
+  free(src);
+  free(simd);
+  free(ref);
+}
+
+int main(void) {
+  // the Game Boy screen, plus sizes that leave 1-3 pixels after the
+  // last 4-pixel group and frames too small for a single group
+  static const int sizes[][2] = { { 160, 144 }, { 161, 7 }, { 13, 11 }, { 6, 2 }, { 3, 3 }, { 1, 1 } };
+
+  for (int f = SCALE_NEAREST; f <= SCALE_XBR; f++) {
+    for (int factor = 1; factor <= 8; factor++) {
+      if (!scale_factor_supported((Scale_Filter_t)f, factor)) continue;
+      for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        check_one((Scale_Filter_t)f, factor, sizes[s][0], sizes[s][1], false);
+      check_one((Scale_Filter_t)f, factor, 160, 144, true);
+    }
+  }
+  return check_done("scale");
+}
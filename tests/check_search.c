@@ -0,0 +1,130 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "search.h"
+#include "memory.h"
+#include "mbc.h"
+#include "check.h"
+
+// from search_scalar.c and search_sse2.c, the same search built with
+// fewer kernels; the plain names pick AVX2 when this CPU has it
+Ram_Search_t *scalar_search_begin(Bus_t *bus, search_region_t region, search_width_t width);
+size_t scalar_search_step(Ram_Search_t *s, Bus_t *bus, search_op_t op, uint32_t operand);
+void scalar_search_free(Ram_Search_t *s);
+Ram_Search_t *sse2_search_begin(Bus_t *bus, search_region_t region, search_width_t width);
+size_t sse2_search_step(Ram_Search_t *s, Bus_t *bus, search_op_t op, uint32_t operand);
+void sse2_search_free(Ram_Search_t *s);
+
+typedef struct {
+  const char *name;
+  Ram_Search_t *(*begin)(Bus_t *bus, search_region_t region, search_width_t width);
+  size_t (*step)(Ram_Search_t *s, Bus_t *bus, search_op_t op, uint32_t operand);
+  void (*free)(Ram_Search_t *s);
+} Search_Impl_t;
+
+static const Search_Impl_t impls[] = {
+  { "scalar", scalar_search_begin, scalar_search_step, scalar_search_free },
+  { "sse2", sse2_search_begin, sse2_search_step, sse2_search_free },
+  { "best", search_begin, search_step, search_free },
+};
+#define IMPLS (sizeof(impls) / sizeof(impls[0]))
+
+static uint32_t rng = 0x9E3779B9u;
+static uint32_t next_rand(void) {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// Small values and valid BCD, so every op keeps some candidates
+static uint8_t random_byte(void) {
+  uint32_t r = next_rand();
+  switch (r & 3) {
+    case 0: return (uint8_t)(r >> 8);
+    case 1: return (uint8_t)(((r >> 8) % 10) << 4 | ((r >> 12) % 10));
+    default: return (uint8_t)((r >> 8) & 7);
+  }
+}
+
+// Half the bytes stay, a quarter move by a little, the rest are new
+static void mutate(uint8_t *mem, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    uint32_t r = next_rand();
+    if ((r & 3) == 2) mem[i] = (uint8_t)(mem[i] + (int)((r >> 8) % 5) - 2);
+    else if ((r & 3) == 3) mem[i] = random_byte();
+  }
+}
+
+static const char *region_names[] = { "wram", "hram", "cart ram" };
+static const char *width_names[] = { "u8", "u16", "bcd8" };
+static const char *op_names[] = { "eq", "changed", "unchanged", "inc", "dec", "inc_by", "dec_by" };
+
+static void check_op(Bus_t *bus, uint8_t *mem, size_t size, search_region_t region,
+                     search_width_t width, search_op_t op, uint32_t operand) {
+  for (size_t i = 0; i < size; i++) mem[i] = random_byte();
+
+  Ram_Search_t *s[IMPLS];
+  for (size_t k = 0; k < IMPLS; k++) s[k] = impls[k].begin(bus, region, width);
+
+  // a few rounds, so later ones run on a sparse candidate set
+  for (int round = 0; round < 3 && s[0]; round++) {
+    mutate(mem, size);
+    size_t want = impls[0].step(s[0], bus, op, operand);
+    for (size_t k = 1; k < IMPLS; k++) {
+      if (!s[k]) continue;
+      size_t got = impls[k].step(s[k], bus, op, operand);
+      size_t words = (size + 63) / 64, w = 0;
+      while (w < words && s[k]->candidates[w] == s[0]->candidates[w]) w++;
+      CHECK(got == want && w == words,
+            "%s %s %s %s %u round %d: %zu candidates, scalar %zu, first diff at offset %zu",
+            impls[k].name, region_names[region], width_names[width], op_names[op],
+            operand, round, got, want, w * 64);
+    }
+  }
+  for (size_t k = 0; k < IMPLS; k++) {
+    CHECK(s[k] != NULL, "%s: search_begin failed", impls[k].name);
+    if (s[k]) impls[k].free(s[k]);
+  }
+}
+
+int main(void) {
+  Bus_t *bus = (Bus_t*)calloc(1, sizeof(Bus_t));
+  Cartridge_t *cart = (Cartridge_t*)calloc(1, sizeof(Cartridge_t));
+  bus->cartridge = cart;
+  static const uint32_t operands[] = { 0, 1, 2, 7, 99, 100, 0x0102, 0xFFFF };
+  // MBC2's 512 nibbles, an 8KB bank, and a size with a partial last word
+  static const size_t cart_sizes[] = { 0x200, 0x2000, 0x2A7 };
+
+  for (int region = SEARCH_WRAM; region <= SEARCH_CART_RAM; region++) {
+    for (size_t c = 0; c < (region == SEARCH_CART_RAM ? 3u : 1u); c++) {
+      uint8_t *mem;
+      size_t size;
+      if (region == SEARCH_WRAM) {
+        mem = bus->wram;
+        size = sizeof(bus->wram);
+      } else if (region == SEARCH_HRAM) {
+        mem = bus->hram;
+        size = sizeof(bus->hram);
+      } else {
+        free(cart->ram);
+        cart->ram_size = cart_sizes[c];
+        cart->ram = (uint8_t*)calloc(1, cart->ram_size);
+        mem = cart->ram;
+        size = cart->ram_size;
+      }
+      for (int width = SEARCH_U8; width <= SEARCH_BCD8; width++) {
+        for (int op = SEARCH_EQ; op <= SEARCH_DEC_BY; op++) {
+          bool by = op == SEARCH_EQ || op == SEARCH_INC_BY || op == SEARCH_DEC_BY;
+          for (size_t o = 0; o < (by ? sizeof(operands) / sizeof(operands[0]) : 1u); o++)
+            check_op(bus, mem, size, (search_region_t)region, (search_width_t)width,
+                     (search_op_t)op, operands[o]);
+        }
+      }
+    }
+  }
+  free(cart->ram);
+  free(cart);
+  free(bus);
+  return check_done("search");
+}
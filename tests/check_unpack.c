@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unpack.h"
+#include "check.h"
+#include "unpack_fixtures.h"
+
+// Same generator the fixtures were made from
+static uint8_t rom_byte(size_t i) {
+  static const char text[] = "NINTENDO GAME BOY CARTRIDGE HEADER ";
+  uint32_t x = (uint32_t)i * 2654435761u;
+  if (((i >> 9) & 3) == 3) return (uint8_t)((x >> 28) & 0xF);
+  return (uint8_t)(text[(i / 3) % (sizeof(text) - 1)] + (i >> 11));
+}
+
+// Plain bitwise CRC-32, independent of the table one in unpack.c
+static uint32_t crc32_ref(const uint8_t *p, size_t n) {
+  uint32_t c = 0xFFFFFFFFu;
+  for (size_t i = 0; i < n; i++) {
+    c ^= p[i];
+    for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+  }
+  return c ^ 0xFFFFFFFFu;
+}
+
+static void check_fixture(const char *name, const uint8_t *data, size_t len,
+                          size_t want_size, uint32_t want_crc) {
+  CHECK(unpack_is_compressed(data, len), "%s: not recognised", name);
+
+  size_t size = 0, padded = 0;
+  uint8_t *rom = unpack_rom(data, len, &size, &padded);
+  CHECK(rom != NULL, "%s: unpack failed", name);
+  if (!rom) return;
+
+  CHECK(size == want_size, "%s: size %zu, want %zu", name, size, want_size);
+  CHECK(padded == ((want_size + 0x3FFF) & ~(size_t)0x3FFF), "%s: padded to %zu", name, padded);
+  if (size == want_size) {
+    uint32_t crc = crc32_ref(rom, size);
+    CHECK(crc == want_crc, "%s: crc %08x, want %08x", name, crc, want_crc);
+    size_t bad = 0;
+    while (bad < size && rom[bad] == rom_byte(bad)) bad++;
+    CHECK(bad == size, "%s: first wrong byte at %zu", name, bad);
+  }
+  size_t pad = size;
+  while (pad < padded && rom[pad] == 0xFF) pad++;
+  CHECK(pad == padded, "%s: padding not 0xFF at %zu", name, pad);
+  free(rom);
+}
+
+// A flipped bit anywhere in the stream must not come back as a ROM
+static void check_corrupt(const char *name, const uint8_t *data, size_t len, size_t at) {
+  uint8_t *copy = (uint8_t*)malloc(len);
+  memcpy(copy, data, len);
+  copy[at] ^= 0x10;
+  size_t size, padded;
+  uint8_t *rom = unpack_rom(copy, len, &size, &padded);
+  CHECK(rom == NULL, "%s: corrupt byte %zu accepted", name, at);
+  free(rom);
+  free(copy);
+}
+
+#define FIXTURE(a, size, crc) check_fixture(#a, a, sizeof(a), size, crc)
+
+int main(void) {
+  FIXTURE(gzip_dynamic, 0x2345, 0x2ed50683u);
+  FIXTURE(gzip_fixed, 0x0A00, 0x7d09e8fbu);
+  FIXTURE(gzip_stored, 0x0300, 0xdf77ec61u);
+  FIXTURE(zip_deflate, 0x4000, 0x3f9d0020u);
+  FIXTURE(zip_stored, 0x0200, 0xe9fb253du);
+
+  // the trailer CRC itself, then data bytes the CRC has to catch
+  check_corrupt("gzip_dynamic", gzip_dynamic, sizeof(gzip_dynamic), sizeof(gzip_dynamic) - 6);
+  check_corrupt("gzip_stored", gzip_stored, sizeof(gzip_stored), 200);
+  check_corrupt("zip_stored", zip_stored, sizeof(zip_stored), 200);
+
+  uint8_t junk[64];
+  memset(junk, 0x1F, sizeof(junk));
+  size_t size, padded;
+  CHECK(!unpack_is_compressed(junk, sizeof(junk)), "junk taken for a container");
+  CHECK(unpack_rom(junk, sizeof(junk), &size, &padded) == NULL, "junk unpacked");
+
+  return check_done("unpack");
+}
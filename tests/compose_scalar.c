@@ -0,0 +1,7 @@
+// core/compose.c again without any SIMD kernel, API renamed for check_compose.c
+#undef __SSE2__
+#undef __ARM_NEON
+#define COMPOSE_NO_AVX2 1
+#define compose_line scalar_compose_line
+#define compose_line_slots scalar_compose_line_slots
+#include "../core/compose.c"
@@ -0,0 +1,5 @@
+// core/compose.c again without the AVX2 kernel, API renamed for check_compose.c
+#define COMPOSE_NO_AVX2 1
+#define compose_line sse2_compose_line
+#define compose_line_slots sse2_compose_line_slots
+#include "../core/compose.c"
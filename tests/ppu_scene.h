@@ -0,0 +1,133 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "ppu.h"
+
+/*
+  Scripted PPU scenes for the checks under tests/. A scene is a bare
+  Bus_t and Ppu_t, no cartridge or CPU, changed only through the bus
+  writes a game would make. scene_reference rebuilds a scene's state in a
+  fresh PPU, whose first complete frame has nothing to reuse.
+*/
+
+typedef struct Scene {
+  Bus_t *bus;
+  Ppu_t *ppu;
+} Scene_t;
+
+// Called at the start of HBlank on every visible line
+typedef void (*scene_hblank_fn)(Scene_t *s, int ly, void *arg);
+
+static uint32_t scene_seed = 0x6C8E9CF5u;
+static inline uint32_t scene_rand(void) {
+  scene_seed ^= scene_seed << 13;
+  scene_seed ^= scene_seed >> 17;
+  scene_seed ^= scene_seed << 5;
+  return scene_seed;
+}
+
+static inline void scene_write(Scene_t *s, uint16_t addy, uint8_t val) {
+  write_byte_bus(s->bus, addy, val);
+}
+
+static inline void scene_open(Scene_t *s, bool cgb) {
+  s->bus = (Bus_t*)malloc(sizeof(Bus_t));
+  init_bus(s->bus);
+  s->bus->is_cgb = cgb;
+  s->ppu = (Ppu_t*)malloc(sizeof(Ppu_t));
+  start_display(s->ppu, s->bus, 1);
+  s->bus->ppu = s->ppu;
+}
+
+static inline void scene_close(Scene_t *s) {
+  Ppu_t *p = s->ppu;
+  ppu_stop_render_thread(p);
+  for (int i = 0; i < PPU_FRAME_BUFFERS; i++) free(p->frames[i]);
+  free(p->gray_frames);
+  free(p->background_buffer);
+  free(p->scaled_framebuffer);
+  free(p->tiles);
+  free(p);
+  free(s->bus);
+}
+
+// Random tiles, maps, attributes, sprites and palettes, with the BG,
+// window (bottom right quarter) and 8x8 sprites on
+static inline void scene_fill(Scene_t *s) {
+  bool cgb = s->bus->is_cgb;
+  for (int bank = 0; bank <= (int)cgb; bank++) {
+    scene_write(s, 0xFF4F, (uint8_t)bank);
+    for (int a = 0x8000; a < 0xA000; a++) scene_write(s, (uint16_t)a, (uint8_t)scene_rand());
+  }
+  scene_write(s, 0xFF4F, 0);
+  for (int i = 0; i < 40; i++) {
+    scene_write(s, (uint16_t)(0xFE00 + i * 4), (uint8_t)(16 + scene_rand() % 144));
+    scene_write(s, (uint16_t)(0xFE01 + i * 4), (uint8_t)(8 + scene_rand() % 160));
+    scene_write(s, (uint16_t)(0xFE02 + i * 4), (uint8_t)scene_rand());
+    scene_write(s, (uint16_t)(0xFE03 + i * 4), (uint8_t)scene_rand());
+  }
+  scene_write(s, 0xFF40, 0xB3);
+  scene_write(s, 0xFF42, (uint8_t)scene_rand());
+  scene_write(s, 0xFF43, (uint8_t)scene_rand());
+  scene_write(s, 0xFF4A, 72);
+  scene_write(s, 0xFF4B, 87);
+  scene_write(s, 0xFF47, 0xE4);
+  scene_write(s, 0xFF48, 0xD2);
+  scene_write(s, 0xFF49, 0x1B);
+  if (cgb) {
+    scene_write(s, 0xFF68, 0x80);
+    for (int i = 0; i < 64; i++) scene_write(s, 0xFF69, (uint8_t)scene_rand());
+    scene_write(s, 0xFF6A, 0x80);
+    for (int i = 0; i < 64; i++) scene_write(s, 0xFF6B, (uint8_t)scene_rand());
+  }
+}
+
+// Runs to the start of the next VBlank and returns the frame just drawn
+static inline const void *scene_frame(Scene_t *s, scene_hblank_fn hblank, void *arg) {
+  Ppu_t *p = s->ppu;
+  int last = -1;
+  p->frame_ready = false;
+  while (!p->frame_ready) {
+    display_cycle(p, s->bus, 4);
+    if (hblank && (p->STAT & 3) == 0 && p->LY < GB_HEIGHT && p->LY != last) {
+      last = p->LY;
+      hblank(s, p->LY, arg);
+    }
+  }
+  ppu_render_flush(p);
+  return ppu_acquire_frame(p, NULL);
+}
+
+// Fresh scene holding src's VRAM, OAM, registers, palettes and format
+static inline void scene_reference(Scene_t *ref, const Scene_t *src) {
+  const Bus_t *b = src->bus;
+  const Ppu_t *p = src->ppu;
+  scene_open(ref, b->is_cgb);
+  ppu_set_format(ref->ppu, p->format);
+  for (int bank = 0; bank <= (int)b->is_cgb; bank++) {
+    scene_write(ref, 0xFF4F, (uint8_t)bank);
+    for (int a = 0; a < 0x2000; a++)
+      scene_write(ref, (uint16_t)(0x8000 + a), b->vram[bank * 0x2000 + a]);
+  }
+  scene_write(ref, 0xFF4F, b->VBK);
+  for (int i = 0; i < OAM_SIZE; i++) scene_write(ref, (uint16_t)(0xFE00 + i), b->oam[i]);
+  scene_write(ref, 0xFF40, p->LCDC);
+  scene_write(ref, 0xFF42, p->SCY);
+  scene_write(ref, 0xFF43, p->SCX);
+  scene_write(ref, 0xFF4A, p->WY);
+  scene_write(ref, 0xFF4B, p->WX);
+  scene_write(ref, 0xFF47, p->BGP);
+  scene_write(ref, 0xFF48, p->OBP0);
+  scene_write(ref, 0xFF49, p->OBP1);
+  if (b->is_cgb) {
+    scene_write(ref, 0xFF68, 0x80);
+    for (int i = 0; i < 64; i++) scene_write(ref, 0xFF69, p->bg_pallete[i]);
+    scene_write(ref, 0xFF6A, 0x80);
+    for (int i = 0; i < 64; i++) scene_write(ref, 0xFF6B, p->obj_pallete[i]);
+  }
+  // the first frame after start_display never draws line 0
+  scene_frame(ref, NULL, NULL);
+}
@@ -0,0 +1,16 @@
+// core/scale.c again with the 4-lane kernels compiled out and the API
+// renamed, so check_scale.c can diff both paths in one program
+#undef __SSE2__
+#undef __ARM_NEON
+#define scale_filter_from_name scalar_scale_filter_from_name
+#define scale_default_factor scalar_scale_default_factor
+#define scale_factor_supported scalar_scale_factor_supported
+#define scaler_create scalar_scaler_create
+#define scaler_submit scalar_scaler_submit
+#define scaler_wait scalar_scaler_wait
+#define scaler_free scalar_scaler_free
+#include "../core/scale.c"
+
+#ifdef SCALE_HAVE_V4
+#error "scale_scalar.c must build without the 4-lane kernels"
+#endif
@@ -0,0 +1,8 @@
+// core/search.c again without any SIMD kernel, API renamed for check_search.c
+#undef __SSE2__
+#define SEARCH_NO_AVX2 1
+#define search_begin scalar_search_begin
+#define search_step scalar_search_step
+#define search_results scalar_search_results
+#define search_free scalar_search_free
+#include "../core/search.c"
@@ -0,0 +1,7 @@
+// core/search.c again without the AVX2 kernel, API renamed for check_search.c
+#define SEARCH_NO_AVX2 1
+#define search_begin sse2_search_begin
+#define search_step sse2_search_step
+#define search_results sse2_search_results
+#define search_free sse2_search_free
+#include "../core/search.c"
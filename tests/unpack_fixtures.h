@@ -0,0 +1,230 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  Known containers for check_unpack.c, made with Python's zlib and
+  zipfile from rom_byte(). The zips put a README.txt ahead of game.gb so
+  the entry pick is covered too.
+*/
+
+// 9029 bytes of ROM, crc32 2ed50683
+static const uint8_t gzip_dynamic[474] = {
+  0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67,
+  0x62, 0x00, 0xed, 0x99, 0xdd, 0x8e, 0x82, 0x30, 0x14, 0x84, 0xfd, 0x5b, 0x7f, 0x57, 0x7d, 0x05,
+  0x50, 0x5f, 0x44, 0x45, 0x11, 0x85, 0x8a, 0x45, 0x50, 0x50, 0xdf, 0xff, 0x35, 0xf6, 0xd3, 0xd2,
+  0xcb, 0xbd, 0xd9, 0xec, 0x1a, 0x74, 0xcf, 0x4d, 0x33, 0x9d, 0xce, 0x39, 0x53, 0x92, 0x49, 0xda,
+  0x14, 0xa5, 0x54, 0x10, 0x04, 0x4a, 0xa9, 0xe3, 0xf1, 0xb8, 0x5a, 0xad, 0x00, 0x9e, 0xe7, 0xed,
+  0xf7, 0x7b, 0xc7, 0x71, 0x7c, 0xdf, 0x9f, 0xcf, 0xe7, 0x51, 0x14, 0xc1, 0x33, 0x5d, 0x2c, 0x16,
+  0xf0, 0x79, 0x9e, 0x83, 0x97, 0xcb, 0x25, 0x4b, 0x5a, 0x6b, 0xaa, 0x18, 0xe9, 0x40, 0x15, 0x7a,
+  0xa3, 0xdc, 0x6c, 0x36, 0x00, 0x04, 0x90, 0x00, 0x04, 0x90, 0x4a, 0x8c, 0xc4, 0x48, 0x8c, 0xc4,
+  0x48, 0x8c, 0xaa, 0x64, 0xd4, 0x1a, 0x75, 0x1b, 0x9f, 0xed, 0x5a, 0xbf, 0x39, 0xec, 0xd4, 0x07,
+  0x1f, 0xe3, 0x5e, 0xf3, 0x3e, 0x79, 0x90, 0xf7, 0xc9, 0x83, 0x2c, 0x15, 0xad, 0x51, 0xa9, 0x18,
+  0x76, 0x4a, 0x45, 0xbb, 0xd6, 0xb3, 0x65, 0xa5, 0xa2, 0x6b, 0x15, 0xf5, 0xfe, 0x2f, 0x37, 0x6e,
+  0xd8, 0xc6, 0x03, 0xdb, 0xb8, 0x65, 0x1b, 0x0f, 0x6d, 0xe3, 0xb6, 0x6d, 0x3c, 0xee, 0xbe, 0xf0,
+  0x7e, 0x9e, 0xfb, 0xa1, 0x2e, 0x81, 0x21, 0x1b, 0x49, 0x92, 0xa4, 0x69, 0xca, 0xb8, 0xdd, 0x6e,
+  0x09, 0x0c, 0x61, 0x5b, 0xaf, 0xd7, 0xae, 0xeb, 0x92, 0x2e, 0x00, 0x02, 0x48, 0x00, 0x02, 0x48,
+  0x82, 0x84, 0x8c, 0x91, 0x12, 0x48, 0x00, 0xab, 0x71, 0x1c, 0xb3, 0x44, 0x21, 0x62, 0x72, 0x68,
+  0xca, 0x49, 0x1a, 0x7c, 0x51, 0x14, 0x60, 0x31, 0x12, 0x23, 0x31, 0x12, 0x23, 0x31, 0xaa, 0x92,
+  0x91, 0x9c, 0xda, 0xdf, 0xee, 0xe7, 0x5f, 0x7c, 0x68, 0x1c, 0xef, 0x76, 0x3b, 0xe2, 0x94, 0x65,
+  0x19, 0x37, 0x46, 0x00, 0x39, 0x39, 0x1c, 0x0e, 0x93, 0xc9, 0x84, 0xf0, 0x90, 0x34, 0x72, 0x02,
+  0xcf, 0x94, 0xa4, 0xc1, 0x5f, 0x2e, 0x17, 0x30, 0x71, 0x62, 0x89, 0xdb, 0x23, 0x55, 0x8c, 0x74,
+  0xa0, 0x0a, 0xbd, 0x51, 0x92, 0x2e, 0x00, 0x02, 0x48, 0x00, 0x02, 0xc8, 0x58, 0x8c, 0xc4, 0x48,
+  0x8c, 0xc4, 0x48, 0x8c, 0x2a, 0x65, 0xf4, 0x0a, 0x87, 0x99, 0x5c, 0x4f, 0xfe, 0xee, 0x51, 0x81,
+  0xc0, 0x90, 0x0d, 0xae, 0x82, 0xa7, 0xd3, 0x89, 0x31, 0x0c, 0x43, 0x02, 0x43, 0xd8, 0xb8, 0x43,
+  0x4e, 0xa7, 0x53, 0xd2, 0x05, 0x30, 0xcf, 0x50, 0x00, 0x04, 0x90, 0x04, 0x09, 0x19, 0x23, 0x25,
+  0x90, 0x00, 0x56, 0xb5, 0xd6, 0x2c, 0x51, 0x88, 0x98, 0x1c, 0x9a, 0x72, 0xf3, 0x4e, 0x75, 0xbd,
+  0x5e, 0xc1, 0x62, 0x24, 0x46, 0x62, 0x24, 0x46, 0x62, 0x54, 0x29, 0xa3, 0x9f, 0x1d, 0x66, 0x6f,
+  0x7a, 0x4a, 0x3e, 0x73, 0x3f, 0x15, 0xf9, 0x50, 0x1d, 0x45, 0x11, 0x71, 0x3a, 0x9f, 0xcf, 0xdc,
+  0x18, 0x01, 0x44, 0x22, 0x49, 0x92, 0xd9, 0x6c, 0x46, 0x78, 0x48, 0x1a, 0x39, 0x81, 0x67, 0x6a,
+  0x9e, 0x8f, 0x6e, 0xb7, 0x1b, 0xd8, 0xfc, 0x93, 0xe2, 0xf6, 0x48, 0x15, 0x23, 0x1d, 0xa8, 0x42,
+  0x6f, 0x94, 0xa4, 0x0b, 0x60, 0x9e, 0xa1, 0x00, 0x08, 0x20, 0xe9, 0x2c, 0x46, 0x62, 0xf4, 0xa6,
+  0x46, 0x5f, 0x83, 0x06, 0xd5, 0x2e, 0x45, 0x23, 0x00, 0x00,
+};
+
+// 2560 bytes of ROM, crc32 7d09e8fb
+static const uint8_t gzip_fixed[280] = {
+  0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67,
+  0x62, 0x00, 0xf3, 0xf3, 0xf3, 0xf3, 0xf4, 0xf4, 0xf4, 0xf3, 0xf3, 0x0b, 0x09, 0x09, 0x71, 0x75,
+  0x75, 0x05, 0x32, 0x5c, 0x5c, 0x5c, 0xfc, 0xfd, 0xfd, 0x15, 0x14, 0x14, 0xdc, 0xdd, 0xdd, 0x1d,
+  0x1d, 0x1d, 0x7d, 0x7d, 0x7d, 0x81, 0xe2, 0x40, 0xae, 0x93, 0x93, 0x13, 0x50, 0x3c, 0x32, 0x32,
+  0x12, 0xc8, 0x76, 0x76, 0x76, 0x06, 0x4a, 0x05, 0x05, 0x05, 0x01, 0x75, 0x01, 0x49, 0xa0, 0x09,
+  0x40, 0x5d, 0x40, 0xf5, 0x10, 0x95, 0x1e, 0x1e, 0x1e, 0x40, 0x06, 0x50, 0x01, 0x50, 0x10, 0xc8,
+  0x00, 0x2a, 0x00, 0x0a, 0xfa, 0x8d, 0x5a, 0x34, 0x6a, 0xd1, 0xa8, 0x45, 0xa3, 0x16, 0x8d, 0x5a,
+  0x34, 0x98, 0x2c, 0x62, 0xe1, 0xe3, 0x60, 0xe2, 0x61, 0x63, 0xe0, 0x62, 0xe6, 0x65, 0x67, 0xe4,
+  0x66, 0xe5, 0xe7, 0x64, 0x06, 0x71, 0xc0, 0x82, 0x20, 0x0e, 0x58, 0x10, 0xaa, 0x82, 0x85, 0x0f,
+  0xaa, 0x82, 0x97, 0x1d, 0xaa, 0x82, 0x8d, 0x81, 0x13, 0xa6, 0x0d, 0xaa, 0x82, 0x03, 0xa6, 0x82,
+  0x91, 0x8b, 0xca, 0x06, 0x33, 0xc1, 0x0c, 0xe6, 0x86, 0x19, 0xcc, 0x02, 0x33, 0x98, 0x17, 0x66,
+  0x30, 0x1b, 0xcc, 0x60, 0x7e, 0x8e, 0x21, 0xec, 0x1e, 0xfa, 0x7a, 0x54, 0x11, 0x98, 0x60, 0x80,
+  0x69, 0x23, 0x38, 0x38, 0x38, 0x34, 0x34, 0x14, 0x48, 0x7a, 0x79, 0x79, 0x01, 0x13, 0x0c, 0x30,
+  0xb1, 0xb9, 0xb9, 0xb9, 0x29, 0x2a, 0x2a, 0x02, 0x53, 0x17, 0x90, 0x01, 0x54, 0x00, 0x14, 0x04,
+  0x32, 0x80, 0x0a, 0x80, 0x82, 0xc0, 0x84, 0x04, 0x54, 0x06, 0x24, 0x81, 0x5a, 0x80, 0x82, 0x40,
+  0x06, 0x50, 0x36, 0x20, 0x20, 0x00, 0x28, 0x05, 0xd4, 0x08, 0x54, 0x0c, 0x4c, 0x87, 0x10, 0xed,
+  0xc0, 0x94, 0x06, 0x14, 0x8f, 0x8a, 0x8a, 0x02, 0xb2, 0x47, 0x2d, 0x1a, 0x8c, 0x16, 0x01, 0x00,
+  0xfb, 0xe8, 0x09, 0x7d, 0x00, 0x0a, 0x00, 0x00,
+};
+
+// 768 bytes of ROM, crc32 df77ec61
+static const uint8_t gzip_stored[799] = {
+  0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67,
+  0x62, 0x00, 0x01, 0x00, 0x03, 0xff, 0xfc, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e,
+  0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20,
+  0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20,
+  0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43,
+  0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44,
+  0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45,
+  0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20, 0x20, 0x20,
+  0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e,
+  0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41,
+  0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f,
+  0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54,
+  0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45,
+  0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44,
+  0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e,
+  0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f,
+  0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45,
+  0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43,
+  0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49,
+  0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48,
+  0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20,
+  0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45,
+  0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47,
+  0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f,
+  0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52,
+  0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47,
+  0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44,
+  0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49,
+  0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44,
+  0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45,
+  0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20,
+  0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52,
+  0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48,
+  0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52,
+  0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54,
+  0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47,
+  0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42,
+  0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41,
+  0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47,
+  0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41,
+  0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e,
+  0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44,
+  0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d,
+  0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59,
+  0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52,
+  0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20,
+  0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45,
+  0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54,
+  0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20,
+  0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x61, 0xec, 0x77, 0xdf, 0x00, 0x03, 0x00, 0x00,
+};
+
+// 16384 bytes of ROM, crc32 3f9d0020
+static const uint8_t zip_deflate[909] = {
+  0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x50, 0x56, 0x42,
+  0xd3, 0x59, 0x0e, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x52, 0x45,
+  0x41, 0x44, 0x4d, 0x45, 0x2e, 0x74, 0x78, 0x74, 0x72, 0x65, 0x61, 0x64, 0x20, 0x6d, 0x65, 0x20,
+  0x66, 0x69, 0x72, 0x73, 0x74, 0x0a, 0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00,
+  0x00, 0x00, 0x21, 0x50, 0x20, 0x00, 0x9d, 0x3f, 0xaf, 0x02, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00,
+  0x07, 0x00, 0x00, 0x00, 0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67, 0x62, 0xed, 0x9a, 0x59, 0x6e, 0xc2,
+  0x40, 0x10, 0x44, 0x43, 0x42, 0x08, 0x59, 0x08, 0x57, 0x60, 0xe7, 0x1c, 0xec, 0xab, 0x17, 0xbc,
+  0x81, 0x6d, 0xb6, 0xfb, 0x9f, 0x22, 0x0f, 0x1a, 0x2b, 0x3f, 0x51, 0x24, 0xa2, 0x88, 0x0c, 0xa1,
+  0x7f, 0x5a, 0xe5, 0x9e, 0xea, 0xae, 0xb1, 0x54, 0x52, 0x8f, 0xc6, 0xb6, 0x6d, 0x7b, 0x32, 0x99,
+  0xd8, 0xb6, 0x1d, 0x04, 0xc1, 0x60, 0x30, 0x00, 0xf4, 0xfb, 0x7d, 0xc7, 0x71, 0x2a, 0x95, 0xca,
+  0x68, 0x34, 0xea, 0x74, 0x3a, 0x96, 0x65, 0x91, 0xe7, 0xb1, 0xdb, 0xed, 0x92, 0x8f, 0xe3, 0x18,
+  0xdc, 0xeb, 0xf5, 0x58, 0xf2, 0x3c, 0x8f, 0x2a, 0x22, 0x1d, 0xa8, 0x82, 0x2f, 0xcc, 0xf1, 0x78,
+  0x0c, 0x80, 0x40, 0x12, 0x00, 0x81, 0xa4, 0xad, 0x42, 0x2a, 0xa4, 0x42, 0x2a, 0xa4, 0x42, 0x26,
+  0x09, 0xe5, 0xdf, 0x8b, 0xf7, 0x6f, 0x85, 0xbb, 0x97, 0x87, 0xd2, 0x53, 0xee, 0xf5, 0xb1, 0xfc,
+  0xfc, 0x70, 0x78, 0x38, 0x26, 0x0f, 0x0f, 0xc7, 0xe4, 0x89, 0x91, 0x7f, 0x3f, 0x31, 0x4a, 0x4f,
+  0x27, 0x46, 0xe1, 0xee, 0x39, 0x2b, 0x3b, 0x31, 0x8a, 0x19, 0x23, 0xf7, 0xf2, 0xcb, 0x8d, 0xef,
+  0xb3, 0xc6, 0xaf, 0x59, 0xe3, 0x7c, 0xd6, 0xb8, 0x94, 0x35, 0x2e, 0x64, 0x8d, 0xcb, 0xc5, 0x2b,
+  0xde, 0xcf, 0x65, 0x5f, 0xb4, 0x8a, 0x61, 0xf0, 0x86, 0xef, 0xfb, 0x61, 0x18, 0x12, 0xa7, 0xd3,
+  0x29, 0x86, 0xc1, 0x6c, 0xc3, 0xe1, 0xb0, 0x5a, 0xad, 0xe2, 0x2e, 0x00, 0x04, 0x92, 0x00, 0x08,
+  0x24, 0x31, 0x12, 0x34, 0x22, 0x25, 0x24, 0x01, 0xac, 0xba, 0xae, 0xcb, 0x12, 0x85, 0x90, 0xf1,
+  0xa1, 0x94, 0xe3, 0x34, 0xf2, 0x49, 0x92, 0x80, 0x55, 0x48, 0x85, 0x54, 0x48, 0x85, 0x54, 0xc8,
+  0x24, 0xa1, 0x6b, 0x9d, 0x92, 0x17, 0xd8, 0xcf, 0x4d, 0xbc, 0xa8, 0xeb, 0xce, 0x66, 0x33, 0xec,
+  0x14, 0x45, 0x11, 0x27, 0x46, 0x00, 0x3e, 0x59, 0x2c, 0x16, 0xb5, 0x5a, 0x0d, 0xf3, 0xe0, 0x34,
+  0x7c, 0x42, 0x9e, 0x47, 0x9c, 0x46, 0x3e, 0x4d, 0x53, 0x30, 0x76, 0x62, 0x89, 0xd3, 0x23, 0x55,
+  0x44, 0x3a, 0x50, 0x05, 0x5f, 0x98, 0xb8, 0x0b, 0x00, 0x81, 0x24, 0x00, 0x02, 0x49, 0x57, 0x85,
+  0x54, 0x48, 0x85, 0x54, 0x48, 0x85, 0x8c, 0x12, 0xba, 0x86, 0x61, 0xf6, 0xf7, 0x53, 0xd2, 0xb4,
+  0xa9, 0xfd, 0x7b, 0x97, 0x0a, 0x18, 0x06, 0x6f, 0x70, 0x14, 0x5c, 0x2e, 0x97, 0xc4, 0xf9, 0x7c,
+  0x8e, 0x61, 0x30, 0x1b, 0x67, 0xc8, 0x7a, 0xbd, 0x8e, 0xbb, 0x00, 0x72, 0x0d, 0x05, 0x80, 0x40,
+  0x12, 0x23, 0x41, 0x23, 0x52, 0x42, 0x12, 0xc0, 0xaa, 0xe7, 0x79, 0x2c, 0x51, 0x08, 0x19, 0x1f,
+  0x4a, 0xb9, 0xdc, 0x53, 0xad, 0xd7, 0x6b, 0xb0, 0x0a, 0xa9, 0x90, 0x0a, 0xa9, 0x90, 0x0a, 0x19,
+  0x25, 0xf4, 0xb3, 0x61, 0xf6, 0x4f, 0xa7, 0xe4, 0x25, 0xf7, 0x63, 0xc8, 0x8b, 0x7a, 0x96, 0x65,
+  0x61, 0xa7, 0xd5, 0x6a, 0xc5, 0x89, 0x11, 0x80, 0x25, 0x7c, 0xdf, 0x6f, 0x34, 0x1a, 0x98, 0x07,
+  0xa7, 0xe1, 0x13, 0xf2, 0x3c, 0xca, 0xf5, 0xd1, 0x66, 0xb3, 0x01, 0xcb, 0x37, 0x29, 0x4e, 0x8f,
+  0x54, 0x11, 0xe9, 0x40, 0x15, 0x7c, 0x61, 0xe2, 0x2e, 0x80, 0x5c, 0x43, 0x01, 0x20, 0x90, 0xa4,
+  0xb3, 0x0a, 0xa9, 0x90, 0x0a, 0xa9, 0x90, 0x0a, 0x99, 0x24, 0x64, 0xf8, 0x94, 0xbc, 0xc0, 0x7e,
+  0x6e, 0xe6, 0x45, 0xbf, 0xdc, 0xcf, 0xf1, 0x53, 0x11, 0x47, 0xc1, 0x38, 0x8e, 0x89, 0xf2, 0x3f,
+  0x09, 0x66, 0xe3, 0x0c, 0xd9, 0x6c, 0x36, 0x71, 0x17, 0x40, 0xae, 0xa1, 0x00, 0x10, 0x48, 0x62,
+  0x24, 0x68, 0x44, 0x4a, 0x48, 0x02, 0x58, 0x0d, 0x82, 0x80, 0x25, 0x0a, 0x21, 0xe3, 0x43, 0x29,
+  0x97, 0x7b, 0xaa, 0xed, 0x76, 0x0b, 0x1e, 0xab, 0x90, 0x0a, 0xa9, 0x90, 0x0a, 0xa9, 0x90, 0x51,
+  0x42, 0x06, 0x0d, 0x33, 0x83, 0xa7, 0xe4, 0xb5, 0xec, 0xe7, 0xfc, 0xc6, 0x8e, 0xe3, 0x60, 0xa7,
+  0x24, 0x49, 0x38, 0x31, 0x02, 0xb0, 0x44, 0x18, 0x86, 0xad, 0x56, 0x0b, 0xf3, 0xe0, 0x34, 0x7c,
+  0x42, 0x9e, 0x47, 0xb9, 0x3e, 0xda, 0xed, 0x76, 0x60, 0xf9, 0x26, 0xc5, 0xe9, 0x91, 0x2a, 0xa2,
+  0xfc, 0x4f, 0x02, 0x5f, 0x98, 0xb8, 0x0b, 0x20, 0xd7, 0x50, 0x00, 0x08, 0x24, 0xe9, 0xac, 0x42,
+  0x2a, 0xa4, 0x42, 0x2a, 0xa4, 0x42, 0x46, 0x09, 0x7d, 0x3b, 0xcc, 0xfe, 0xe9, 0x94, 0xd4, 0x4b,
+  0x85, 0xcf, 0xfd, 0x1c, 0x3e, 0x15, 0x71, 0x14, 0x4c, 0xd3, 0x94, 0x28, 0xff, 0x93, 0x60, 0x36,
+  0xce, 0x90, 0xed, 0x76, 0x1b, 0x77, 0x01, 0xe4, 0x1a, 0x0a, 0x00, 0x81, 0x24, 0x46, 0x82, 0x46,
+  0xa4, 0x84, 0x24, 0x80, 0xd5, 0x28, 0x8a, 0x58, 0xa2, 0x10, 0x32, 0x3e, 0x94, 0x72, 0xb9, 0xa7,
+  0xda, 0xef, 0xf7, 0x60, 0xf9, 0x26, 0xa5, 0x42, 0x2a, 0xa4, 0x42, 0x2a, 0xa4, 0x42, 0xc6, 0x08,
+  0xdd, 0xcc, 0xd4, 0xbe, 0x99, 0x17, 0x3d, 0x6f, 0x3f, 0x1f, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03,
+  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x50, 0x56, 0x42, 0xd3, 0x59, 0x0e, 0x00,
+  0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x52, 0x45, 0x41, 0x44, 0x4d, 0x45, 0x2e, 0x74,
+  0x78, 0x74, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+  0x21, 0x50, 0x20, 0x00, 0x9d, 0x3f, 0xaf, 0x02, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x07, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x36, 0x00, 0x00, 0x00,
+  0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67, 0x62, 0x50, 0x4b, 0x05, 0x06, 0x00, 0x00, 0x00, 0x00, 0x02,
+  0x00, 0x02, 0x00, 0x6d, 0x00, 0x00, 0x00, 0x0a, 0x03, 0x00, 0x00, 0x00, 0x00,
+};
+
+// 512 bytes of ROM, crc32 e9fb253d
+static const uint8_t zip_stored[734] = {
+  0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x50, 0x56, 0x42,
+  0xd3, 0x59, 0x0e, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x52, 0x45,
+  0x41, 0x44, 0x4d, 0x45, 0x2e, 0x74, 0x78, 0x74, 0x72, 0x65, 0x61, 0x64, 0x20, 0x6d, 0x65, 0x20,
+  0x66, 0x69, 0x72, 0x73, 0x74, 0x0a, 0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x21, 0x50, 0x3d, 0x25, 0xfb, 0xe9, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+  0x07, 0x00, 0x00, 0x00, 0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67, 0x62, 0x4e, 0x4e, 0x4e, 0x49, 0x49,
+  0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44,
+  0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45,
+  0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20,
+  0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52,
+  0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48,
+  0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52,
+  0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54,
+  0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47,
+  0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42,
+  0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41,
+  0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47,
+  0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41,
+  0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e,
+  0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44,
+  0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d,
+  0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59,
+  0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52,
+  0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20,
+  0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45,
+  0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e, 0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54,
+  0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e, 0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20,
+  0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41, 0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20,
+  0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59, 0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41,
+  0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54, 0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44,
+  0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45,
+  0x41, 0x41, 0x41, 0x44, 0x44, 0x44, 0x45, 0x45, 0x45, 0x52, 0x52, 0x52, 0x20, 0x20, 0x20, 0x4e,
+  0x4e, 0x4e, 0x49, 0x49, 0x49, 0x4e, 0x4e, 0x4e, 0x54, 0x54, 0x54, 0x45, 0x45, 0x45, 0x4e, 0x4e,
+  0x4e, 0x44, 0x44, 0x44, 0x4f, 0x4f, 0x4f, 0x20, 0x20, 0x20, 0x47, 0x47, 0x47, 0x41, 0x41, 0x41,
+  0x4d, 0x4d, 0x4d, 0x45, 0x45, 0x45, 0x20, 0x20, 0x20, 0x42, 0x42, 0x42, 0x4f, 0x4f, 0x4f, 0x59,
+  0x59, 0x59, 0x20, 0x20, 0x20, 0x43, 0x43, 0x43, 0x41, 0x41, 0x41, 0x52, 0x52, 0x52, 0x54, 0x54,
+  0x54, 0x52, 0x52, 0x52, 0x49, 0x49, 0x49, 0x44, 0x44, 0x44, 0x47, 0x47, 0x47, 0x45, 0x45, 0x45,
+  0x20, 0x20, 0x20, 0x48, 0x48, 0x48, 0x45, 0x45, 0x45, 0x41, 0x41, 0x50, 0x4b, 0x01, 0x02, 0x14,
+  0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x50, 0x56, 0x42, 0xd3, 0x59, 0x0e,
+  0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x52, 0x45, 0x41, 0x44, 0x4d, 0x45, 0x2e,
+  0x74, 0x78, 0x74, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x21, 0x50, 0x3d, 0x25, 0xfb, 0xe9, 0x00, 0x02, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x07,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x36, 0x00, 0x00,
+  0x00, 0x67, 0x61, 0x6d, 0x65, 0x2e, 0x67, 0x62, 0x50, 0x4b, 0x05, 0x06, 0x00, 0x00, 0x00, 0x00,
+  0x02, 0x00, 0x02, 0x00, 0x6d, 0x00, 0x00, 0x00, 0x5b, 0x02, 0x00, 0x00, 0x00, 0x00,
+};